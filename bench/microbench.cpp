@@ -0,0 +1,455 @@
+/*
+    Hakkapeliitta - A UCI chess engine. Copyright (C) 2013-2015 Mikko Aarnos.
+
+    Hakkapeliitta is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Hakkapeliitta is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Hakkapeliitta. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/// @file microbench.cpp
+/// @author Mikko Aarnos
+///
+/// Microbenchmarks for the hot kernels of the engine.
+/// Every kernel is run over a corpus of positions a number of times and the timings are printed as JSON.
+///
+/// Usage: microbench [-positions <file with one FEN per line>] [-syzygy <path>] [-samples <n>]
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../src/bitboards.hpp"
+#include "../src/zobrist.hpp"
+#include "../src/evaluation.hpp"
+#include "../src/movegen.hpp"
+#include "../src/position.hpp"
+#include "../src/tt.hpp"
+#include "../src/syzygy/tbprobe.hpp"
+#include "../src/utils/stopwatch.hpp"
+#include "../src/utils/threadpool.hpp"
+
+// Prevents the compiler from optimizing the benchmarked code away.
+static volatile uint64_t sink;
+
+// A position together with its pseudo-legal and legal moves, calculated beforehand so that they don't affect the timings.
+struct CorpusPosition
+{
+    CorpusPosition(const Position& newPos) : pos(newPos), inCheck(newPos.inCheck())
+    {
+        inCheck ? MoveGen::generateLegalEvasions(pos, pseudoLegalMoves) : MoveGen::generatePseudoLegalMoves(pos, pseudoLegalMoves);
+        for (auto i = 0; i < pseudoLegalMoves.size(); ++i)
+        {
+            const auto move = pseudoLegalMoves.getMove(i);
+            if (pos.legal(move, inCheck))
+            {
+                legalMoves.push_back(move);
+            }
+        }
+    }
+
+    Position pos;
+    bool inCheck;
+    MoveList pseudoLegalMoves;
+    std::vector<Move> legalMoves;
+};
+
+struct KernelResult
+{
+    std::string name;
+    uint64_t operationsPerSample;
+    std::vector<double> nanosecondsPerOperation;
+    bool skipped;
+};
+
+// Builds the default corpus by playing out a fixed pseudo-random game from each of a set of opening, middlegame and endgame positions.
+static std::vector<Position> defaultCorpus()
+{
+    static const std::vector<std::string> fens = {
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+        "rnbqkb1r/pp1p1ppp/2p5/4P3/2B5/8/PPP1NnPP/RNBQK2R w KQkq - 0 6",
+        "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+        "2r3k1/1q1nbppp/r3p3/3pP3/pPpP4/P1Q2N2/2RN1PPP/2R4K b - b3 0 23",
+        "r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP1B1PPP/R2QKB1R w KQ - 0 8",
+        "8/8/4k3/8/2p5/8/B2P2K1/8 w - - 0 1",
+        "8/5pk1/6p1/3R4/8/6P1/5PK1/3r4 w - - 0 40",
+    };
+    std::vector<Position> corpus;
+    auto seed = 0x9E3779B97F4A7C15ULL;
+
+    for (auto& fen : fens)
+    {
+        Position pos(fen);
+        for (auto ply = 0; ply < 60; ++ply)
+        {
+            corpus.push_back(pos);
+            const CorpusPosition cp(pos);
+            if (cp.legalMoves.empty() || pos.getFiftyMoveDistance() >= 100)
+            {
+                break;
+            }
+            seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+            pos.makeMove(cp.legalMoves[(seed >> 33) % cp.legalMoves.size()]);
+        }
+    }
+
+    return corpus;
+}
+
+// Runs a kernel a given amount of times, each sample lasting at least about 20ms so that the timer resolution doesn't matter.
+static KernelResult runKernel(const std::string& name, int samples, const std::function<uint64_t()>& kernel)
+{
+    KernelResult result;
+    result.name = name;
+    result.skipped = false;
+
+    // The first run warms up the caches and tells us how many operations one run does.
+    const auto operationsPerRun = kernel();
+    if (!operationsPerRun)
+    {
+        result.skipped = true;
+        result.operationsPerSample = 0;
+        return result;
+    }
+
+    Stopwatch sw;
+    sw.start();
+    kernel();
+    sw.stop();
+    const auto runsPerSample = std::max<uint64_t>(1, 20000000 / std::max<uint64_t>(1, sw.elapsed<std::chrono::nanoseconds>()));
+    result.operationsPerSample = runsPerSample * operationsPerRun;
+
+    for (auto i = 0; i < samples; ++i)
+    {
+        sw.start();
+        for (uint64_t j = 0; j < runsPerSample; ++j)
+        {
+            kernel();
+        }
+        sw.stop();
+        result.nanosecondsPerOperation.push_back(static_cast<double>(sw.elapsed<std::chrono::nanoseconds>()) / result.operationsPerSample);
+    }
+
+    return result;
+}
+
+static double median(std::vector<double> values)
+{
+    std::sort(values.begin(), values.end());
+    const auto n = values.size();
+    return (n % 2 ? values[n / 2] : (values[n / 2 - 1] + values[n / 2]) / 2);
+}
+
+static void printJson(const std::vector<KernelResult>& results, size_t corpusSize, int samples)
+{
+    std::cout << "{" << std::endl;
+    std::cout << "  \"positions\": " << corpusSize << "," << std::endl;
+    std::cout << "  \"samples\": " << samples << "," << std::endl;
+    std::cout << "  \"kernels\": [" << std::endl;
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        auto& r = results[i];
+        std::cout << "    { \"name\": \"" << r.name << "\"";
+        if (r.skipped)
+        {
+            std::cout << ", \"skipped\": true }";
+        }
+        else
+        {
+            // The median absolute deviation tells how stable the timings were.
+            const auto med = median(r.nanosecondsPerOperation);
+            std::vector<double> deviations;
+            for (auto t : r.nanosecondsPerOperation)
+            {
+                deviations.push_back(std::fabs(t - med));
+            }
+            std::cout << ", \"operations\": " << r.operationsPerSample
+                      << ", \"median_ns\": " << med
+                      << ", \"min_ns\": " << *std::min_element(r.nanosecondsPerOperation.begin(), r.nanosecondsPerOperation.end())
+                      << ", \"mad_ns\": " << median(deviations) << " }";
+        }
+        std::cout << (i + 1 < results.size() ? "," : "") << std::endl;
+    }
+    std::cout << "  ]" << std::endl;
+    std::cout << "}" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    Bitboards::staticInitialize();
+    Zobrist::staticInitialize();
+    Evaluation::staticInitialize();
+
+    std::string positionFile, syzygyPath;
+    auto samples = 15;
+    for (auto i = 1; i + 1 < argc; i += 2)
+    {
+        const std::string arg = argv[i];
+        if (arg == "-positions") positionFile = argv[i + 1];
+        else if (arg == "-syzygy") syzygyPath = argv[i + 1];
+        else if (arg == "-samples") samples = std::max(1, std::stoi(argv[i + 1]));
+    }
+
+    std::vector<Position> positions;
+    if (!positionFile.empty())
+    {
+        std::ifstream file(positionFile);
+        std::string fen;
+        while (std::getline(file, fen))
+        {
+            if (!fen.empty())
+            {
+                positions.emplace_back(fen);
+            }
+        }
+    }
+    if (positions.empty())
+    {
+        positions = defaultCorpus();
+    }
+
+    std::vector<CorpusPosition> corpus;
+    for (auto& pos : positions)
+    {
+        corpus.emplace_back(pos);
+    }
+
+    std::vector<KernelResult> results;
+    MoveList moveList;
+
+    results.push_back(runKernel("movegen_pseudolegal", samples, [&]()
+    {
+        uint64_t operations = 0;
+        for (auto& cp : corpus)
+        {
+            if (cp.inCheck) continue;
+            moveList.clear();
+            MoveGen::generatePseudoLegalMoves(cp.pos, moveList);
+            sink = sink + moveList.size();
+            ++operations;
+        }
+        return operations;
+    }));
+
+    results.push_back(runKernel("movegen_evasions", samples, [&]()
+    {
+        uint64_t operations = 0;
+        for (auto& cp : corpus)
+        {
+            if (!cp.inCheck) continue;
+            moveList.clear();
+            MoveGen::generateLegalEvasions(cp.pos, moveList);
+            sink = sink + moveList.size();
+            ++operations;
+        }
+        return operations;
+    }));
+
+    results.push_back(runKernel("movegen_captures", samples, [&]()
+    {
+        uint64_t operations = 0;
+        for (auto& cp : corpus)
+        {
+            if (cp.inCheck) continue;
+            moveList.clear();
+            MoveGen::generatePseudoLegalCaptures(cp.pos, moveList, true);
+            sink = sink + moveList.size();
+            ++operations;
+        }
+        return operations;
+    }));
+
+    // Picking every move of a list in order like the search does, with scores spread like history scores.
+    std::vector<MoveList> scoredLists;
+    for (auto& cp : corpus)
+    {
+        scoredLists.push_back(cp.pseudoLegalMoves);
+        auto& scoredList = scoredLists.back();
+        for (auto i = 0; i < scoredList.size(); ++i)
+        {
+            scoredList.setScore(i, static_cast<int16_t>((scoredList.getMove(i).getRawMove() * 2654435761u) >> 20) - 2048);
+        }
+    }
+    results.push_back(runKernel("movelist_pick", samples, [&]()
+    {
+        uint64_t operations = 0;
+        for (auto& scoredList : scoredLists)
+        {
+            moveList = scoredList;
+            for (auto i = 0; i < moveList.size(); ++i)
+            {
+                moveList.swap(i, moveList.bestIndex(i, moveList.size()));
+                sink = sink + moveList.getMove(i).getRawMove();
+                ++operations;
+            }
+        }
+        return operations;
+    }));
+
+    results.push_back(runKernel("position_makemove", samples, [&]()
+    {
+        uint64_t operations = 0;
+        for (auto& cp : corpus)
+        {
+            for (auto& move : cp.legalMoves)
+            {
+                Position newPosition(cp.pos);
+                newPosition.makeMove(move);
+                sink = sink + newPosition.getHashKey();
+                ++operations;
+            }
+        }
+        return operations;
+    }));
+
+    results.push_back(runKernel("position_see", samples, [&]()
+    {
+        uint64_t operations = 0;
+        for (auto& cp : corpus)
+        {
+            for (auto i = 0; i < cp.pseudoLegalMoves.size(); ++i)
+            {
+                sink = sink + cp.pos.SEE(cp.pseudoLegalMoves.getMove(i));
+                ++operations;
+            }
+        }
+        return operations;
+    }));
+
+    // The threshold used by SEE pruning, compare with position_see.
+    results.push_back(runKernel("position_seege", samples, [&]()
+    {
+        uint64_t operations = 0;
+        for (auto& cp : corpus)
+        {
+            for (auto i = 0; i < cp.pseudoLegalMoves.size(); ++i)
+            {
+                sink = sink + cp.pos.seeGe(cp.pseudoLegalMoves.getMove(i), 0);
+                ++operations;
+            }
+        }
+        return operations;
+    }));
+
+    results.push_back(runKernel("position_givescheck", samples, [&]()
+    {
+        uint64_t operations = 0;
+        for (auto& cp : corpus)
+        {
+            for (auto& move : cp.legalMoves)
+            {
+                sink = sink + cp.pos.givesCheck(move);
+                ++operations;
+            }
+        }
+        return operations;
+    }));
+
+    results.push_back(runKernel("position_legal", samples, [&]()
+    {
+        uint64_t operations = 0;
+        for (auto& cp : corpus)
+        {
+            for (auto i = 0; i < cp.pseudoLegalMoves.size(); ++i)
+            {
+                sink = sink + cp.pos.legal(cp.pseudoLegalMoves.getMove(i), cp.inCheck);
+                ++operations;
+            }
+        }
+        return operations;
+    }));
+
+    Evaluation evaluation;
+    results.push_back(runKernel("evaluation_evaluate", samples, [&]()
+    {
+        uint64_t operations = 0;
+        for (auto& cp : corpus)
+        {
+            sink = sink + evaluation.evaluate(cp.pos);
+            ++operations;
+        }
+        return operations;
+    }));
+
+    // Use a large table and spread the keys all over it so that the results show the cost of cache misses, like in a real search.
+    TranspositionTable transpositionTable;
+    transpositionTable.setSize(256);
+    std::vector<HashKey> keys;
+    for (auto& cp : corpus)
+    {
+        for (auto& move : cp.legalMoves)
+        {
+            Position newPosition(cp.pos);
+            newPosition.makeMove(move);
+            keys.push_back(newPosition.getHashKey());
+        }
+    }
+
+    results.push_back(runKernel("tt_save", samples, [&]()
+    {
+        for (auto key : keys)
+        {
+            transpositionTable.save(key, Move(), static_cast<int>(key & 0xFF), 1, TranspositionTable::Flags::ExactScore, 0);
+        }
+        return static_cast<uint64_t>(keys.size());
+    }));
+
+    results.push_back(runKernel("tt_probe", samples, [&]()
+    {
+        for (auto key : keys)
+        {
+            sink = sink + (transpositionTable.probe(key) != nullptr);
+        }
+        return static_cast<uint64_t>(keys.size());
+    }));
+
+    // Fork/join overhead of the thread pool: one tiny task per position, so the scheduling dominates.
+    ThreadPool threadPool(std::max(static_cast<int>(std::thread::hardware_concurrency()) - 1, 1));
+    results.push_back(runKernel("threadpool_fanout", samples, [&]()
+    {
+        threadPool.parallelFor(0, corpus.size(), [&](size_t i)
+        {
+            sink = sink + corpus[i].pos.getHashKey();
+        });
+        return static_cast<uint64_t>(corpus.size());
+    }));
+
+    if (!syzygyPath.empty())
+    {
+        Syzygy::initialize(syzygyPath);
+    }
+    results.push_back(runKernel("syzygy_probewdl", samples, [&]()
+    {
+        uint64_t operations = 0;
+        if (!Syzygy::maxCardinality)
+        {
+            return operations;
+        }
+        for (auto& cp : corpus)
+        {
+            if (cp.pos.getTotalPieceCount() > Syzygy::maxCardinality || cp.pos.getCastlingRights()) continue;
+            int success;
+            sink = sink + Syzygy::probeWdl(cp.pos, success);
+            ++operations;
+        }
+        return operations;
+    }));
+
+    printJson(results, corpus.size(), samples);
+
+    return 0;
+}
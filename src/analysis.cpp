@@ -0,0 +1,250 @@
+/*
+    Hakkapeliitta - A UCI chess engine. Copyright (C) 2013-2015 Mikko Aarnos.
+
+    Hakkapeliitta is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Hakkapeliitta is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Hakkapeliitta. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "analysis.hpp"
+#include <algorithm>
+#include <functional>
+#include <sstream>
+#include <thread>
+#include "search.hpp"
+#include "textio.hpp"
+
+Analysis::Analysis(const std::string& inputFileName, const std::string& outputFileName, Mode mode) :
+    mMode(mode), mInputFile(inputFileName), mOutputFile(outputFileName), mPositionsRead(0), mPositionsWritten(0),
+    mTestCount(0), mSolvedCount(0), mTotalSolutionTime(0)
+{
+}
+
+uint64_t Analysis::run(const SearchParameters& sp, int threads, size_t transpositionTableSize, size_t pawnHashTableSize)
+{
+    std::vector<std::thread> workers;
+
+    for (auto i = 0; i < threads; ++i)
+    {
+        workers.emplace_back(&Analysis::worker, this, std::cref(sp),
+                             std::max(transpositionTableSize / threads, static_cast<size_t>(1)), pawnHashTableSize);
+    }
+
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+
+    mOutputFile.flush();
+    return mPositionsWritten;
+}
+
+bool Analysis::nextPosition(std::string& line, uint64_t& index)
+{
+    std::unique_lock<std::mutex> lock(mFileMutex);
+
+    while (std::getline(mInputFile, line))
+    {
+        if (line.find_first_not_of(" \t\r") != std::string::npos)
+        {
+            index = mPositionsRead++;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void Analysis::writeResult(uint64_t index, const std::string& result)
+{
+    std::unique_lock<std::mutex> lock(mFileMutex);
+
+    mPendingResults[index] = result;
+    // Results finishing out of order wait here until all results before them have been written.
+    for (auto it = mPendingResults.begin(); it != mPendingResults.end() && it->first == mPositionsWritten; it = mPendingResults.erase(it))
+    {
+        mOutputFile << it->second << '\n';
+        ++mPositionsWritten;
+    }
+}
+
+void Analysis::worker(const SearchParameters& sp, size_t transpositionTableSize, size_t pawnHashTableSize)
+{
+    ResultListener listener;
+    Search search(listener);
+    search.setTranspositionTableSize(transpositionTableSize);
+    search.setPawnHashTableSize(pawnHashTableSize);
+
+    SearchParameters searchParameters(sp);
+    searchParameters.mRootPly = 0;
+    searchParameters.mHashKeys.assign(1024, 0);
+
+    std::string line;
+    uint64_t index;
+    while (nextPosition(line, index))
+    {
+        // An EPD line contains the first four fields of a FEN followed by operations, a FEN line contains six fields.
+        // Only the position is given to the search, of the operations only the id is copied to the output.
+        std::istringstream iss(line);
+        std::string epd, token, halfMoves = "0", fullMoves = "1";
+        for (auto i = 0; i < 4 && iss >> token; ++i)
+        {
+            epd += (i ? " " : "") + token;
+        }
+
+        std::string operations;
+        std::getline(iss, operations);
+        std::istringstream counters(operations);
+        std::string first, second;
+        if (counters >> first >> second
+            && first.find_first_not_of("0123456789") == std::string::npos
+            && second.find_first_not_of("0123456789") == std::string::npos)
+        {
+            halfMoves = first;
+            fullMoves = second;
+            std::getline(counters, operations);
+        }
+
+        std::string id;
+        std::istringstream operationStream(operations);
+        while (std::getline(operationStream, token, ';'))
+        {
+            const auto start = token.find_first_not_of(' ');
+            if (start != std::string::npos && token.compare(start, 3, "id ") == 0)
+            {
+                id = " " + token.substr(start) + ";";
+            }
+        }
+
+        const Position pos(epd + " " + halfMoves + " " + fullMoves);
+        listener.reset();
+        search.go(pos, searchParameters);
+        listener.waitForBestMove();
+
+        if (mMode == TestSuite)
+        {
+            writeResult(index, testResult(pos, id.empty() ? "position " + std::to_string(index + 1) : id.substr(1, id.size() - 2), operations, listener));
+            continue;
+        }
+
+        std::ostringstream result;
+        result << epd;
+        if (!listener.mPv.empty())
+        {
+            result << " bm " << moveToUciFormat(listener.mPv[0]) << ";";
+        }
+        result << " ce " << listener.mScore << ";";
+        if (isMateScore(listener.mScore))
+        {
+            const auto mateInMoves = (listener.mScore > 0 ? ((mateScore - listener.mScore + 1) >> 1) : -((listener.mScore + mateScore) >> 1));
+            result << " dm " << mateInMoves << ";";
+        }
+        result << " acd " << listener.mDepth << ";"
+               << " acn " << listener.mNodeCount << ";";
+        if (!listener.mPv.empty())
+        {
+            auto pv = movesToUciFormat(listener.mPv);
+            pv.pop_back(); // Remove the trailing space.
+            result << " pv " << pv << ";";
+        }
+        result << id;
+
+        writeResult(index, result.str());
+    }
+}
+
+std::string Analysis::testResult(const Position& pos, const std::string& id, const std::string& operations, const ResultListener& listener)
+{
+    // Translate the bm and am operations into moves. They are usually in SAN but UCI-format is accepted as well.
+    // Check, mate and annotation marks are ignored when comparing SAN.
+    const auto stripMarks = [](std::string s)
+    {
+        s.erase(std::remove_if(s.begin(), s.end(), [](char c) { return c == '+' || c == '#' || c == '!' || c == '?'; }), s.end());
+        return s;
+    };
+    MoveList moveList;
+    const auto inCheck = pos.inCheck();
+    inCheck ? MoveGen::generateLegalEvasions(pos, moveList) : MoveGen::generatePseudoLegalMoves(pos, moveList);
+
+    std::vector<Move> bestMoves, avoidMoves;
+    std::istringstream operationStream(operations);
+    std::string operation;
+    while (std::getline(operationStream, operation, ';'))
+    {
+        std::istringstream iss(operation);
+        std::string opcode, operand;
+        iss >> opcode;
+        if (opcode != "bm" && opcode != "am")
+        {
+            continue;
+        }
+
+        while (iss >> operand)
+        {
+            for (auto i = 0; i < moveList.size(); ++i)
+            {
+                const auto move = moveList.getMove(i);
+                if (pos.legal(move, inCheck) 
+                    && (stripMarks(moveToSanFormat(pos, move)) == stripMarks(operand) || moveToUciFormat(move) == operand))
+                {
+                    (opcode == "bm" ? bestMoves : avoidMoves).push_back(move);
+                }
+            }
+        }
+    }
+
+    if (bestMoves.empty() && avoidMoves.empty())
+    {
+        return id + ": no bm or am";
+    }
+
+    const auto correct = [&](const Move& move)
+    {
+        return (bestMoves.empty() || std::find(bestMoves.begin(), bestMoves.end(), move) != bestMoves.end())
+            && std::find(avoidMoves.begin(), avoidMoves.end(), move) == avoidMoves.end();
+    };
+
+    // The position is solved at the point after which the best move was always correct.
+    const auto& changes = listener.mBestMoveChanges;
+    auto solvedAt = changes.size();
+    while (solvedAt > 0 && correct(changes[solvedAt - 1].mMove))
+    {
+        --solvedAt;
+    }
+    const auto solved = (!listener.mPv.empty() && correct(listener.mPv[0]) && solvedAt < changes.size());
+
+    std::ostringstream result;
+    result << id;
+    if (solved)
+    {
+        result << ": solved"
+               << " time " << changes[solvedAt].mSearchTime
+               << " depth " << changes[solvedAt].mDepth
+               << " nodes " << changes[solvedAt].mNodeCount;
+    }
+    else
+    {
+        result << ": not solved, best move " << (listener.mPv.empty() ? "(none)" : moveToSanFormat(pos, listener.mPv[0]));
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(mFileMutex);
+        ++mTestCount;
+        if (solved)
+        {
+            ++mSolvedCount;
+            mTotalSolutionTime += changes[solvedAt].mSearchTime;
+        }
+    }
+
+    return result.str();
+}
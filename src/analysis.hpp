@@ -0,0 +1,123 @@
+/*
+    Hakkapeliitta - A UCI chess engine. Copyright (C) 2013-2015 Mikko Aarnos.
+
+    Hakkapeliitta is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Hakkapeliitta is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Hakkapeliitta. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/// @file analysis.hpp
+/// @author Mikko Aarnos
+
+#ifndef ANALYSIS_HPP_
+#define ANALYSIS_HPP_
+
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "position.hpp"
+#include "result_listener.hpp"
+#include "search_parameters.hpp"
+
+/// @brief Used for analysing a file of positions in parallel.
+///
+/// Every thread has its own search function with its own TT and PHT, so the threads never wait for each other except when reading a new position or writing a result.
+/// The results are written in the same order as the positions were in the input file, regardless of the order they finish in.
+class Analysis
+{
+public:
+    /// @brief The different things we can do with the positions.
+    ///
+    /// Analyse writes the results of the searches as EPD operations. 
+    /// TestSuite checks the results against the bm and am operations of the positions and records when the correct move was found.
+    enum Mode
+    {
+        Analyse, TestSuite
+    };
+
+    /// @brief Constructs a new analysis.
+    /// @param inputFileName The file to read the positions from, one EPD or FEN per line.
+    /// @param outputFileName The file to write the results to.
+    /// @param mode What to do with the positions.
+    Analysis(const std::string& inputFileName, const std::string& outputFileName, Mode mode);
+
+    /// @brief Analyses all positions in the input file.
+    /// @param sp The parameters given to each search. Should contain a depth, node or time limit.
+    /// @param threads The amount of positions analysed at the same time.
+    /// @param transpositionTableSize The total size of the TTs in megabytes, divided evenly between the threads.
+    /// @param pawnHashTableSize The size of the PHT of each thread in megabytes.
+    /// @return The amount of positions analysed.
+    uint64_t run(const SearchParameters& sp, int threads, size_t transpositionTableSize, size_t pawnHashTableSize);
+
+    /// @brief Checks if the input and output files were opened succesfully.
+    /// @return True if both files are open.
+    bool isOpen() const;
+
+    /// @brief Get the amount of positions with a bm or am operation. Only counted in the test suite mode.
+    /// @return The amount of positions.
+    uint64_t getTestCount() const;
+
+    /// @brief Get the amount of positions solved. Only counted in the test suite mode.
+    /// @return The amount of positions.
+    uint64_t getSolvedCount() const;
+
+    /// @brief Get the average time it took to find the correct move in the solved positions.
+    /// @return The average time in milliseconds.
+    uint64_t getAverageSolutionTime() const;
+
+private:
+    void worker(const SearchParameters& sp, size_t transpositionTableSize, size_t pawnHashTableSize);
+
+    // Reads the next position from the input file. Returns false when the file has run out.
+    bool nextPosition(std::string& line, uint64_t& index);
+
+    // Stores the result of the position with the given index and writes all results which are now in order.
+    void writeResult(uint64_t index, const std::string& result);
+
+    // Checks the result of the search against the bm and am operations and returns the line to be written to the output.
+    std::string testResult(const Position& pos, const std::string& id, const std::string& operations, const ResultListener& listener);
+
+    Mode mMode;
+    std::ifstream mInputFile;
+    std::ofstream mOutputFile;
+    std::mutex mFileMutex;
+    uint64_t mPositionsRead;
+    uint64_t mPositionsWritten;
+    std::map<uint64_t, std::string> mPendingResults;
+    uint64_t mTestCount;
+    uint64_t mSolvedCount;
+    uint64_t mTotalSolutionTime;
+};
+
+inline bool Analysis::isOpen() const
+{
+    return mInputFile.is_open() && mOutputFile.is_open();
+}
+
+inline uint64_t Analysis::getTestCount() const
+{
+    return mTestCount;
+}
+
+inline uint64_t Analysis::getSolvedCount() const
+{
+    return mSolvedCount;
+}
+
+inline uint64_t Analysis::getAverageSolutionTime() const
+{
+    return (mSolvedCount ? mTotalSolutionTime / mSolvedCount : 0);
+}
+
+#endif
@@ -24,7 +24,7 @@ std::pair<uint64_t, uint64_t> Benchmark::runPerft(const Position& pos, int depth
     Stopwatch sw;
 
     sw.start();
-    const auto perftResult = perft(pos, depth, pos.inCheck());
+    const auto perftResult = perft(pos, depth);
     sw.stop();
 
     return std::make_pair(perftResult, sw.elapsed<std::chrono::milliseconds>());
@@ -57,7 +57,7 @@ std::pair<uint64_t, uint64_t> Benchmark::testPerft()
     {
         auto& test = tests[i];
         Position pos(test.mFen);
-        const auto result = perft(pos, test.mDepth, pos.inCheck());
+        const auto result = perft(pos, test.mDepth);
         total += result;
         if (result != test.mResult)
         {
@@ -71,29 +71,23 @@ std::pair<uint64_t, uint64_t> Benchmark::testPerft()
     return std::make_pair(total, sw.elapsed<std::chrono::milliseconds>());
 }
 
-uint64_t Benchmark::perft(const Position& pos, int depth, bool inCheck)
+uint64_t Benchmark::perft(const Position& pos, int depth)
 {
     MoveList moveList;
-    auto nodes = 0ULL; 
+    MoveGen::generateLegalMoves(pos, moveList);
 
-    inCheck ? MoveGen::generateLegalEvasions(pos, moveList) : MoveGen::generatePseudoLegalMoves(pos, moveList);
-    for (auto i = 0; i < moveList.size(); ++i)
+    // Every generated move is legal, so the leaves don't have to be visited at all.
+    if (depth == 1)
     {
-        const auto move = moveList.getMove(i);
-        if (!pos.legal(move, inCheck))
-        {
-            continue;
-        }
-
-        if (depth == 1)
-        {
-            ++nodes;
-            continue;
-        }
+        return moveList.size();
+    }
 
+    auto nodes = 0ULL;
+    for (auto i = 0; i < moveList.size(); ++i)
+    {
         Position newPos(pos);
-        newPos.makeMove(move);
-        nodes += depth == 1 ? 1 : perft(newPos, depth - 1, newPos.inCheck());
+        newPos.makeMove(moveList.getMove(i));
+        nodes += perft(newPos, depth - 1);
     }
 
     return nodes;
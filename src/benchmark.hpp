@@ -44,7 +44,7 @@ public:
     static std::pair<uint64_t, uint64_t> testPerft();
 
 private:
-    static uint64_t perft(const Position& pos, int depth, bool inCheck);
+    static uint64_t perft(const Position& pos, int depth);
 };
 
 #endif
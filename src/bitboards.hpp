@@ -120,6 +120,43 @@ public:
     /// @return A bitboard which has the square of the king, all king attacks from that square and three (or two) squares in front of those marked.
     static Bitboard kingSafetyZone(Color c, Square sq);
 
+    /// @brief Smears every set bit of a given bitboard towards the 8th rank.
+    /// @param bb The bitboard.
+    /// @return The filled bitboard, the original bits included.
+    static Bitboard northFill(Bitboard bb) noexcept;
+
+    /// @brief Smears every set bit of a given bitboard towards the 1st rank.
+    /// @param bb The bitboard.
+    /// @return The filled bitboard, the original bits included.
+    static Bitboard southFill(Bitboard bb) noexcept;
+
+    /// @brief Smears every set bit of a given bitboard over its whole file.
+    /// @param bb The bitboard.
+    /// @return A bitboard with every file containing at least one set bit marked.
+    static Bitboard fileFill(Bitboard bb) noexcept;
+
+    /// @brief Gets the squares in front of the set bits of a given bitboard, from the point of view of a given color.
+    /// @param c The color.
+    /// @param bb The bitboard.
+    /// @return The front span, the original bits excluded.
+    static Bitboard frontSpan(Color c, Bitboard bb);
+
+    /// @brief Shifts a given bitboard one file towards the H-file.
+    /// @param bb The bitboard.
+    /// @return The shifted bitboard. Nothing wraps around to the A-file.
+    static Bitboard eastOne(Bitboard bb) noexcept;
+
+    /// @brief Shifts a given bitboard one file towards the A-file.
+    /// @param bb The bitboard.
+    /// @return The shifted bitboard. Nothing wraps around to the H-file.
+    static Bitboard westOne(Bitboard bb) noexcept;
+
+    /// @brief Get all squares attacked by a set of pawns of a given color at once.
+    /// @param c The color of the pawns.
+    /// @param pawns The pawns.
+    /// @return A bitboard containing every square attacked by at least one of the pawns.
+    static Bitboard allPawnAttacks(Color c, Bitboard pawns);
+
     /// @brief An array containing all rank bitboards.
     static const std::array<Bitboard, 8> ranks;
 
@@ -298,6 +335,47 @@ inline Bitboard Bitboards::kingSafetyZone(Color c, Square sq)
     return mKingZone[c][sq]; 
 }
 
+inline Bitboard Bitboards::northFill(Bitboard bb) noexcept
+{
+    bb |= bb << 8;
+    bb |= bb << 16;
+    bb |= bb << 32;
+    return bb;
+}
+
+inline Bitboard Bitboards::southFill(Bitboard bb) noexcept
+{
+    bb |= bb >> 8;
+    bb |= bb >> 16;
+    bb |= bb >> 32;
+    return bb;
+}
+
+inline Bitboard Bitboards::fileFill(Bitboard bb) noexcept
+{
+    return northFill(bb) | southFill(bb);
+}
+
+inline Bitboard Bitboards::frontSpan(Color c, Bitboard bb)
+{
+    return (c ? southFill(bb >> 8) : northFill(bb << 8));
+}
+
+inline Bitboard Bitboards::eastOne(Bitboard bb) noexcept
+{
+    return (bb << 1) & 0xFEFEFEFEFEFEFEFE;
+}
+
+inline Bitboard Bitboards::westOne(Bitboard bb) noexcept
+{
+    return (bb >> 1) & 0x7F7F7F7F7F7F7F7F;
+}
+
+inline Bitboard Bitboards::allPawnAttacks(Color c, Bitboard pawns)
+{
+    return (c ? westOne(pawns >> 8) | eastOne(pawns >> 8) : westOne(pawns << 8) | eastOne(pawns << 8));
+}
+
 template <bool hardwarePopcntEnabled>
 inline int Bitboards::popcnt(Bitboard bb) noexcept
 {
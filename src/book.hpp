@@ -0,0 +1,76 @@
+/*
+    Hakkapeliitta - A UCI chess engine. Copyright (C) 2013-2015 Mikko Aarnos.
+
+    Hakkapeliitta is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Hakkapeliitta is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Hakkapeliitta. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/// @file book.hpp
+/// @author Mikko Aarnos
+
+#ifndef BOOK_HPP_
+#define BOOK_HPP_
+
+#include <memory>
+#include <random>
+#include <string>
+#include "move.hpp"
+#include "position.hpp"
+#include "zobrist.hpp"
+#include "utils/mapped_file.hpp"
+
+/// @brief An opening book in the Polyglot format.
+///
+/// The book file is memory-mapped read-only, so after opening it no more file reads are needed and the pages are shared between all engine processes using the same book.
+/// A Polyglot book is a sorted array of 16-byte big-endian entries, each containing a key, a move, a weight and learning data, so moves are found with a binary search.
+class Book
+{
+public:
+    /// @brief Default constructor.
+    Book();
+
+    /// @brief Opens a book file, closing the previously opened one.
+    /// @param fileName The name of the file.
+    /// @return True if the file was opened succesfully.
+    bool open(const std::string& fileName);
+
+    /// @brief Closes the book file.
+    void close();
+
+    /// @brief Checks if a book file is open.
+    /// @return True if it is.
+    bool isOpen() const;
+
+    /// @brief Picks a move for a given position from the book. Moves are picked randomly, the probability of a move being proportional to its weight.
+    /// @param pos The position.
+    /// @return The move, an empty move if the position is not in the book.
+    Move getMove(const Position& pos);
+
+    /// @brief Calculates the Polyglot hash key of a given position. Not the same as the hash key used internally, Polyglot uses its own random numbers.
+    /// @param pos The position.
+    /// @return The hash key.
+    ///
+    /// Calculated from scratch as it is only needed at the root. Maintaining it incrementally would make every move made in the search slower.
+    static HashKey polyglotKey(const Position& pos);
+
+private:
+    std::unique_ptr<MappedFile> mFile;
+    std::mt19937 mRng;
+};
+
+inline bool Book::isOpen() const
+{
+    return mFile && mFile->isOpen();
+}
+
+#endif
@@ -101,6 +101,9 @@ const int razoringDepth = 3;
 /// @brief The max depth we use SEE pruning at.
 const int seePruningDepth = 3;
 
+/// @brief The longest mate we try to prove with the mate search, the normal search finds longer mates faster.
+const int mateSearchMoves = 3;
+
 // Move ordering scores.
 // Delete as soon as MoveSort works everywhere.
 /// @brief The move ordering score given to a TT-move.
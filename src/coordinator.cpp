@@ -0,0 +1,221 @@
+/*
+    Hakkapeliitta - A UCI chess engine. Copyright (C) 2013-2015 Mikko Aarnos.
+
+    Hakkapeliitta is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Hakkapeliitta is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Hakkapeliitta. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "coordinator.hpp"
+#include <algorithm>
+#include <limits>
+#include <sstream>
+#include <thread>
+#include "constants.hpp"
+#include "movegen.hpp"
+#include "textio.hpp"
+
+Coordinator::Coordinator(const std::string& engineCommand, int processes, size_t transpositionTableSize) :
+    mOpen(processes > 0)
+{
+    for (auto i = 0; i < processes; ++i)
+    {
+        mProcesses.emplace_back(new ChildProcess(engineCommand));
+    }
+
+    const auto hashSize = std::max(transpositionTableSize / std::max(processes, 1), static_cast<size_t>(1));
+    for (auto& process : mProcesses)
+    {
+        mOpen = mOpen && process->isOpen() && waitFor(*process, "uci", "uciok");
+        if (mOpen)
+        {
+            process->writeLine("setoption name Hash value " + std::to_string(hashSize));
+        }
+    }
+}
+
+Coordinator::~Coordinator()
+{
+    for (auto& process : mProcesses)
+    {
+        process->writeLine("quit");
+    }
+}
+
+bool Coordinator::waitFor(ChildProcess& process, const std::string& command, const std::string& answer)
+{
+    std::string line;
+    process.writeLine(command);
+    while (process.readLine(line))
+    {
+        if (line == answer)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::vector<Coordinator::Result> Coordinator::run(const Position& pos, const std::string& positionCommand, const std::string& limits)
+{
+    MoveList moveList;
+    MoveGen::generateLegalMoves(pos, moveList);
+    std::vector<Move> rootMoves;
+    for (auto i = 0; i < moveList.size(); ++i)
+    {
+        rootMoves.push_back(moveList.getMove(i));
+    }
+
+    // Captures and promotions are the most likely best moves, put them first so that they are spread over all processes.
+    std::stable_partition(rootMoves.begin(), rootMoves.end(), [&](const Move& move) { return pos.captureOrPromotion(move); });
+
+    std::vector<Result> results(std::min(mProcesses.size(), rootMoves.size()));
+    for (size_t i = 0; i < rootMoves.size(); ++i)
+    {
+        results[i % results.size()].mMoves.push_back(rootMoves[i]);
+    }
+
+    std::vector<std::thread> readers;
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        auto& process = *mProcesses[i];
+        auto& result = results[i];
+        waitFor(process, "isready", "readyok");
+        process.writeLine(positionCommand);
+        process.writeLine("go " + limits + " searchmoves " + movesToUciFormat(result.mMoves));
+        readers.emplace_back(&Coordinator::readResult, std::ref(process), std::cref(pos), std::ref(result));
+    }
+
+    for (auto& reader : readers)
+    {
+        reader.join();
+    }
+
+    return results;
+}
+
+void Coordinator::readResult(ChildProcess& process, const Position& pos, Result& result)
+{
+    std::string line;
+    result.mScore = -infinity;
+    result.mDepth = 0;
+    result.mNodeCount = 0;
+    result.mScores.clear();
+
+    while (process.readLine(line))
+    {
+        std::istringstream iss(line);
+        std::string s;
+        iss >> s;
+        if (s == "bestmove")
+        {
+            break;
+        }
+        if (s != "info")
+        {
+            continue;
+        }
+
+        // Only take exact scores, bounds from a failed aspiration search can be way off.
+        auto depth = 0, score = -infinity;
+        auto exact = true;
+        std::vector<Move> pv;
+        while (iss >> s)
+        {
+            if (s == "depth") { iss >> depth; }
+            else if (s == "nodes") { iss >> result.mNodeCount; }
+            else if (s == "lowerbound" || s == "upperbound") { exact = false; }
+            else if (s == "cp") { iss >> score; }
+            else if (s == "mate")
+            {
+                iss >> score;
+                score = (score > 0 ? mateInPly(2 * score - 1) : matedInPly(-2 * score));
+            }
+            else if (s == "string") { break; }
+            else if (s == "pv")
+            {
+                Position newPosition(pos);
+                while (iss >> s)
+                {
+                    const auto move = uciFormatToMove(newPosition, s);
+                    pv.push_back(move);
+                    newPosition.makeMove(move);
+                }
+            }
+        }
+
+        if (exact && !pv.empty() && score != -infinity)
+        {
+            result.mPv = pv;
+            result.mScore = score;
+            result.mDepth = depth;
+            if (depth >= static_cast<int>(result.mScores.size()))
+            {
+                result.mScores.resize(depth + 1, -infinity);
+            }
+            result.mScores[depth] = score;
+        }
+    }
+}
+
+int Coordinator::scoreAtDepth(const Result& result, int depth)
+{
+    for (auto d = std::min(depth, static_cast<int>(result.mScores.size()) - 1); d >= 0; --d)
+    {
+        if (result.mScores[d] != -infinity)
+        {
+            return result.mScores[d];
+        }
+    }
+    return -infinity;
+}
+
+Coordinator::Result Coordinator::merge(const std::vector<Result>& results)
+{
+    Result merged;
+    merged.mScore = -infinity;
+    merged.mDepth = 0;
+    merged.mNodeCount = 0;
+
+    auto commonDepth = std::numeric_limits<int>::max();
+    for (auto& result : results)
+    {
+        if (!result.mPv.empty())
+        {
+            commonDepth = std::min(commonDepth, result.mDepth);
+        }
+    }
+
+    // The best move is chosen at the common depth, but we report the deepest result of its process.
+    auto bestScore = -infinity;
+    for (auto& result : results)
+    {
+        merged.mMoves.insert(merged.mMoves.end(), result.mMoves.begin(), result.mMoves.end());
+        merged.mNodeCount += result.mNodeCount;
+        if (result.mPv.empty())
+        {
+            continue;
+        }
+
+        const auto score = scoreAtDepth(result, commonDepth);
+        if (merged.mPv.empty() || score > bestScore || (score == bestScore && result.mDepth > merged.mDepth))
+        {
+            bestScore = score;
+            merged.mPv = result.mPv;
+            merged.mScore = result.mScore;
+            merged.mDepth = result.mDepth;
+            merged.mScores = result.mScores;
+        }
+    }
+
+    return merged;
+}
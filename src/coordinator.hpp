@@ -0,0 +1,106 @@
+/*
+    Hakkapeliitta - A UCI chess engine. Copyright (C) 2013-2015 Mikko Aarnos.
+
+    Hakkapeliitta is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Hakkapeliitta is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Hakkapeliitta. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/// @file coordinator.hpp
+/// @author Mikko Aarnos
+
+#ifndef COORDINATOR_HPP_
+#define COORDINATOR_HPP_
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "move.hpp"
+#include "position.hpp"
+#include "utils/child_process.hpp"
+
+/// @brief Splits the root moves of a position between several UCI engine processes and merges their results.
+///
+/// Each process searches its own share of the root moves with "go searchmoves" and its own TT, so the processes never communicate with each other.
+/// This wastes some work compared to a shared search, but it spreads one hard analysis over all sockets of a big machine with no effort at all.
+class Coordinator
+{
+public:
+    /// @brief The result of one process, or the merged result of all of them.
+    struct Result
+    {
+        /// @brief The root moves searched.
+        std::vector<Move> mMoves;
+
+        /// @brief The principal variation of the best move, empty if the process sent no PV.
+        std::vector<Move> mPv;
+
+        /// @brief The score of the principal variation.
+        int mScore;
+
+        /// @brief The depth of the principal variation.
+        int mDepth;
+
+        /// @brief The exact score of every depth completed, indexed by depth. -infinity for depths without an exact score.
+        std::vector<int> mScores;
+
+        /// @brief The amount of nodes searched.
+        uint64_t mNodeCount;
+    };
+
+    /// @brief Starts the engine processes and initializes them.
+    /// @param engineCommand The command used for starting an engine.
+    /// @param processes The amount of processes to start.
+    /// @param transpositionTableSize The total size of the TTs in megabytes, divided evenly between the processes.
+    Coordinator(const std::string& engineCommand, int processes, size_t transpositionTableSize);
+
+    /// @brief Destructor, tells the engines to quit.
+    ~Coordinator();
+
+    /// @brief Checks if every engine process was started and answered to "uci".
+    /// @return True if all of them did.
+    bool isOpen() const;
+
+    /// @brief Searches a position with every process.
+    /// @param pos The position.
+    /// @param positionCommand The "position" command giving the position to the engines, including the moves so that they know the repetitions.
+    /// @param limits The search limits given to each "go" command, for example "depth 20". Must not be infinite.
+    /// @return The results of all processes which searched something. The results are in the same order as the processes.
+    std::vector<Result> run(const Position& pos, const std::string& positionCommand, const std::string& limits);
+
+    /// @brief Merges the results of the processes.
+    /// @param results The results.
+    /// @return The result with the best score, with the nodes of every process and all moves searched.
+    ///
+    /// The processes reach different depths, and a shallow score is often too optimistic. So the scores are compared at the deepest depth completed by all processes.
+    static Result merge(const std::vector<Result>& results);
+
+private:
+    std::vector<std::unique_ptr<ChildProcess>> mProcesses;
+    bool mOpen;
+
+    // Sends a command to a process and waits for the given answer. Returns false if the process quit first.
+    static bool waitFor(ChildProcess& process, const std::string& command, const std::string& answer);
+
+    // Reads the output of a process until "bestmove", keeping the last exact PV.
+    static void readResult(ChildProcess& process, const Position& pos, Result& result);
+
+    // The exact score of the deepest depth at most the given one, -infinity if there is none.
+    static int scoreAtDepth(const Result& result, int depth);
+};
+
+inline bool Coordinator::isOpen() const
+{
+    return mOpen;
+}
+
+#endif
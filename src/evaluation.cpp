@@ -24,15 +24,16 @@
 std::array<std::array<short, 64>, 12> Evaluation::mPieceSquareTableOpening;
 std::array<std::array<short, 64>, 12> Evaluation::mPieceSquareTableEnding;
 
-const std::array<short, 6> pieceValuesOpening = {
+// The parameters of the evaluation function are not const so that they can be tuned, see getParameterGroups.
+std::array<int, 6> pieceValuesOpening = {
     79, 248, 253, 355, 847, 0
 };
 
-const std::array<short, 6> pieceValuesEnding = {
+std::array<int, 6> pieceValuesEnding = {
     127, 275, 292, 526, 939, 0
 };
 
-const std::array<std::array<short, 64>, 6> openingPST = {{
+std::array<std::array<int, 64>, 6> openingPST = {{
     {
         0, 0, 0, 0, 0, 0, 0, 0, -35, -28, -32, -38, -17, -3, -4, -39, -35, -23, -31, -25, -11, -1, -10, -26, -31, -17, -16, -7, 2, 1, -18, -21, -22, -6, -9, 6, 20, 14, -1, -15, 4, -7, 27, 27, 52, 60, 51, 15, 55, 44, 89, 100, 87, 64, -11, -24, 0, 0, 0, 0, 0, 0, 0, 0
     },
@@ -53,7 +54,7 @@ const std::array<std::array<short, 64>, 6> openingPST = {{
     }
 }};
 
-const std::array<std::array<short, 64>, 6> endingPST = {{
+std::array<std::array<int, 64>, 6> endingPST = {{
     {
         0, 0, 0, 0, 0, 0, 0, 0, -12, -3, -10, 0, 4, -9, -13, -20, -19, -8, -17, -16, -16, -19, -14, -22, -11, -3, -21, -29, -24, -19, -10, -20, 9, 0, -6, -26, -21, -15, 1, -5, 42, 44, 11, 7, -7, 10, 31, 20, 56, 71, 62, 14, 52, 17, 16, 42, 0, 0, 0, 0, 0, 0, 0, 0
     },
@@ -74,7 +75,7 @@ const std::array<std::array<short, 64>, 6> endingPST = {{
     }
 }};
 
-const std::array<std::vector<int>, 6> mobilityOpening = {{
+std::array<std::vector<int>, 6> mobilityOpening = {{
     {},
     { -1, 6, 12, 16, 17, 16, 16, 15, 18 },
     { -12, -7, -2, 1, 6, 14, 17, 22, 19, 23, 21, 34, 34, 29 },
@@ -83,7 +84,7 @@ const std::array<std::vector<int>, 6> mobilityOpening = {{
     {}
 }};
 
-const std::array<std::vector<int>, 6> mobilityEnding = {{
+std::array<std::vector<int>, 6> mobilityEnding = {{
     {},
     { -30, 1, 4, 11, 16, 25, 23, 23, 19 },
     { -22, -32, -19, -6, 5, 20, 29, 33, 42, 40, 36, 38, 28, 13 },
@@ -92,43 +93,43 @@ const std::array<std::vector<int>, 6> mobilityEnding = {{
     {}
 }};
 
-const std::array<int, 8> passedBonusOpening = {
+std::array<int, 8> passedBonusOpening = {
     0, 4, -19, -8, 19, 48, 58, 0
 };
 
-const std::array<int, 8> passedBonusEnding = {
+std::array<int, 8> passedBonusEnding = {
     0, 4, 17, 32, 51, 67, 90, 0
 };
 
-const std::array<int, 8> doubledPenaltyOpening = {
+std::array<int, 8> doubledPenaltyOpening = {
     36, 9, 2, 23, 18, 20, 0, 26
 };
 
-const std::array<int, 8> doubledPenaltyEnding = {
+std::array<int, 8> doubledPenaltyEnding = {
     46, 25, 31, 24, 21, 19, 29, 44
 };
 
-const std::array<int, 8> isolatedPenaltyOpening = {
+std::array<int, 8> isolatedPenaltyOpening = {
     1, 5, 14, 13, 22, 14, 14, 20
 };
 
-const std::array<int, 8> isolatedPenaltyEnding = {
+std::array<int, 8> isolatedPenaltyEnding = {
     5, 13, 21, 26, 22, 16, 10, 6
 };
 
-const std::array<int, 8> backwardPenaltyOpening = {
+std::array<int, 8> backwardPenaltyOpening = {
     -4, 3, 2, 21, 8, 7, 13, -1
 };
 
-const std::array<int, 8> backwardPenaltyEnding = {
+std::array<int, 8> backwardPenaltyEnding = {
     2, 7, 13, 14, 7, 1, 1, 3
 };
 
-const int bishopPairBonusOpening = 42;
-const int bishopPairBonusEnding = 52;
-const int sideToMoveBonus = 1;
+int bishopPairBonusOpening = 42;
+int bishopPairBonusEnding = 52;
+int sideToMoveBonus = 1;
 
-const std::array<int, 6> attackWeight = {
+std::array<int, 6> attackWeight = {
     0, 2, 2, 3, 5, 0
 };
 
@@ -151,6 +152,60 @@ void Evaluation::staticInitialize()
     }
 }
 
+std::vector<Evaluation::ParameterGroup> Evaluation::getParameterGroups()
+{
+    std::vector<ParameterGroup> groups;
+    const auto addGroup = [&groups](const std::string& name, int* values, size_t size)
+    {
+        groups.push_back({ name, {} });
+        for (size_t i = 0; i < size; ++i)
+        {
+            groups.back().mValues.push_back(values + i);
+        }
+    };
+
+    // The value of the king and the pawn PST on the first and last ranks never affect the evaluation, so they are left out.
+    addGroup("pieceValuesOpening (without king)", pieceValuesOpening.data(), Piece::King);
+    addGroup("pieceValuesEnding (without king)", pieceValuesEnding.data(), Piece::King);
+    addGroup("openingPST[0] (a2-h7)", openingPST[Piece::Pawn].data() + 8, 48);
+    for (Piece p = Piece::Knight; p <= Piece::King; ++p)
+    {
+        addGroup("openingPST[" + std::to_string(p) + "]", openingPST[p].data(), openingPST[p].size());
+    }
+    addGroup("endingPST[0] (a2-h7)", endingPST[Piece::Pawn].data() + 8, 48);
+    for (Piece p = Piece::Knight; p <= Piece::King; ++p)
+    {
+        addGroup("endingPST[" + std::to_string(p) + "]", endingPST[p].data(), endingPST[p].size());
+    }
+    for (Piece p = Piece::Knight; p <= Piece::Queen; ++p)
+    {
+        addGroup("mobilityOpening[" + std::to_string(p) + "]", mobilityOpening[p].data(), mobilityOpening[p].size());
+    }
+    for (Piece p = Piece::Knight; p <= Piece::Queen; ++p)
+    {
+        addGroup("mobilityEnding[" + std::to_string(p) + "]", mobilityEnding[p].data(), mobilityEnding[p].size());
+    }
+    addGroup("passedBonusOpening", passedBonusOpening.data(), passedBonusOpening.size());
+    addGroup("passedBonusEnding", passedBonusEnding.data(), passedBonusEnding.size());
+    addGroup("doubledPenaltyOpening", doubledPenaltyOpening.data(), doubledPenaltyOpening.size());
+    addGroup("doubledPenaltyEnding", doubledPenaltyEnding.data(), doubledPenaltyEnding.size());
+    addGroup("isolatedPenaltyOpening", isolatedPenaltyOpening.data(), isolatedPenaltyOpening.size());
+    addGroup("isolatedPenaltyEnding", isolatedPenaltyEnding.data(), isolatedPenaltyEnding.size());
+    addGroup("backwardPenaltyOpening", backwardPenaltyOpening.data(), backwardPenaltyOpening.size());
+    addGroup("backwardPenaltyEnding", backwardPenaltyEnding.data(), backwardPenaltyEnding.size());
+    addGroup("bishopPairBonusOpening", &bishopPairBonusOpening, 1);
+    addGroup("bishopPairBonusEnding", &bishopPairBonusEnding, 1);
+    addGroup("sideToMoveBonus", &sideToMoveBonus, 1);
+    addGroup("attackWeight", attackWeight.data(), attackWeight.size());
+
+    return groups;
+}
+
+Evaluation::Evaluation() :
+mPawnHashTableProbes(0), mPawnHashTableHits(0)
+{
+}
+
 int Evaluation::evaluate(const Position& pos)
 {
     return (Bitboards::hardwarePopcntSupported() ? evaluate<true>(pos) : evaluate<false>(pos));
@@ -172,9 +227,11 @@ int Evaluation::evaluate(const Position& pos)
     std::array<int, 2> kingSafetyScore;
     const auto phase = clamp(static_cast<int>(pos.getGamePhase()), 0, 64); // The phase can be negative in some weird cases, guard against that.
 
-    auto score = mobilityEval<hardwarePopcnt>(pos, kingSafetyScore, phase);
-    score += pawnStructureEval(pos, phase);
-    score += kingSafetyEval(pos, phase, kingSafetyScore);
+    const auto& pawnEntry = pawnStructureEval<hardwarePopcnt>(pos);
+
+    auto score = mobilityEval<hardwarePopcnt>(pos, pawnEntry, kingSafetyScore, phase);
+    score += interpolateScore(pawnEntry.getScoreOp(), pawnEntry.getScoreEd(), phase);
+    score += kingSafetyEval(pos, pawnEntry, phase, kingSafetyScore);
     score += interpolateScore(pos.getPstScoreOp(), pos.getPstScoreEd(), phase);
 
     // Bishop pair bonus.
@@ -193,93 +250,263 @@ int Evaluation::evaluate(const Position& pos)
 }
 
 template <bool hardwarePopcnt> 
-int Evaluation::mobilityEval(const Position& pos, std::array<int, 2>& kingSafetyScore, int phase)
+int Evaluation::mobilityEval(const Position& pos, const PawnHashTable::PawnHashTableEntry& pawnEntry, std::array<int, 2>& kingSafetyScore, int phase)
 {
-    const auto occupied = pos.getOccupiedSquares();
     auto scoreOp = 0, scoreEd = 0;
 
-    for (Color c = Color::White; c <= Color::Black; ++c)
-    {
-        const auto targetBitboard = ~pos.getPieces(c);
-        const auto opponentKingZone = Bitboards::kingSafetyZone(!c, Bitboards::lsb(pos.getBitboard(!c, Piece::King)));
-        auto scoreOpForColor = 0, scoreEdForColor = 0;
-        auto attackUnits = 0;
+    mobilityEvalForColor<hardwarePopcnt, Color::White>(pos, pawnEntry, kingSafetyScore[Color::White], scoreOp, scoreEd);
+    mobilityEvalForColor<hardwarePopcnt, Color::Black>(pos, pawnEntry, kingSafetyScore[Color::Black], scoreOp, scoreEd);
 
-        auto tempPiece = pos.getBitboard(c, Piece::Knight);
-        while (tempPiece)
-        {
-            const auto from = Bitboards::popLsb(tempPiece);
-            const auto tempMove = Bitboards::knightAttacks(from) & targetBitboard;
-            const auto count = Bitboards::popcnt<hardwarePopcnt>(tempMove);
-            scoreOpForColor += mobilityOpening[Piece::Knight][count];
-            scoreEdForColor += mobilityEnding[Piece::Knight][count];
-            attackUnits += attackWeight[Piece::Knight] * Bitboards::popcnt<hardwarePopcnt>(tempMove & opponentKingZone);
-        }
+    return interpolateScore(scoreOp, scoreEd, phase);
+}
 
-        tempPiece = pos.getBitboard(c, Piece::Bishop);
-        while (tempPiece)
-        {
-            const auto from = Bitboards::popLsb(tempPiece);
-            auto tempMove = Bitboards::bishopAttacks(from, occupied) & targetBitboard;
-            const auto count = Bitboards::popcnt<hardwarePopcnt>(tempMove);
-            scoreOpForColor += mobilityOpening[Piece::Bishop][count];
-            scoreEdForColor += mobilityEnding[Piece::Bishop][count];
-            tempMove = Bitboards::bishopAttacks(from, occupied ^ pos.getBitboard(c, Piece::Queen)) & targetBitboard;
-            attackUnits += attackWeight[Piece::Bishop] * Bitboards::popcnt<hardwarePopcnt>(tempMove & opponentKingZone);
-        }
+template <bool hardwarePopcnt, int8_t c> 
+void Evaluation::mobilityEvalForColor(const Position& pos, const PawnHashTable::PawnHashTableEntry& pawnEntry, int& kingSafetyScore, int& scoreOp, int& scoreEd)
+{
+    const auto occupied = pos.getOccupiedSquares();
+    const auto targetBitboard = ~pos.getPieces(c);
+    const auto opponentKingZone = Bitboards::kingSafetyZone(!c, Bitboards::lsb(pos.getBitboard(!c, Piece::King)));
+    auto scoreOpForColor = 0, scoreEdForColor = 0;
+    auto attackUnits = 0;
+
+    auto tempPiece = pos.getBitboard(c, Piece::Knight);
+    while (tempPiece)
+    {
+        const auto from = Bitboards::popLsb(tempPiece);
+        const auto tempMove = Bitboards::knightAttacks(from) & targetBitboard;
+        const auto count = Bitboards::popcnt<hardwarePopcnt>(tempMove);
+        scoreOpForColor += mobilityOpening[Piece::Knight][count];
+        scoreEdForColor += mobilityEnding[Piece::Knight][count];
+        attackUnits += attackWeight[Piece::Knight] * Bitboards::popcnt<hardwarePopcnt>(tempMove & opponentKingZone);
+    }
 
-        tempPiece = pos.getBitboard(c, Piece::Rook);
-        while (tempPiece)
+    tempPiece = pos.getBitboard(c, Piece::Bishop);
+    while (tempPiece)
+    {
+        const auto from = Bitboards::popLsb(tempPiece);
+        auto tempMove = Bitboards::bishopAttacks(from, occupied) & targetBitboard;
+        const auto count = Bitboards::popcnt<hardwarePopcnt>(tempMove);
+        scoreOpForColor += mobilityOpening[Piece::Bishop][count];
+        scoreEdForColor += mobilityEnding[Piece::Bishop][count];
+        tempMove = Bitboards::bishopAttacks(from, occupied ^ pos.getBitboard(c, Piece::Queen)) & targetBitboard;
+        attackUnits += attackWeight[Piece::Bishop] * Bitboards::popcnt<hardwarePopcnt>(tempMove & opponentKingZone);
+    }
+
+    tempPiece = pos.getBitboard(c, Piece::Rook);
+    while (tempPiece)
+    {
+        const auto from = Bitboards::popLsb(tempPiece);
+        auto tempMove = Bitboards::rookAttacks(from, occupied) & targetBitboard;
+        const auto count = Bitboards::popcnt<hardwarePopcnt>(tempMove);
+        scoreOpForColor += mobilityOpening[Piece::Rook][count];
+        scoreEdForColor += mobilityEnding[Piece::Rook][count];
+        tempMove = Bitboards::rookAttacks(from, occupied ^ pos.getBitboard(c, Piece::Queen) ^ pos.getBitboard(c, Piece::Rook)) & targetBitboard;
+        attackUnits += attackWeight[Piece::Rook] * Bitboards::popcnt<hardwarePopcnt>(tempMove & opponentKingZone);
+
+        if (pawnEntry.isSemiOpenFile(c, file(from)))
         {
-            const auto from = Bitboards::popLsb(tempPiece);
-            auto tempMove = Bitboards::rookAttacks(from, occupied) & targetBitboard;
-            const auto count = Bitboards::popcnt<hardwarePopcnt>(tempMove);
-            scoreOpForColor += mobilityOpening[Piece::Rook][count];
-            scoreEdForColor += mobilityEnding[Piece::Rook][count];
-            tempMove = Bitboards::rookAttacks(from, occupied ^ pos.getBitboard(c, Piece::Queen) ^ pos.getBitboard(c, Piece::Rook)) & targetBitboard;
-            attackUnits += attackWeight[Piece::Rook] * Bitboards::popcnt<hardwarePopcnt>(tempMove & opponentKingZone);
-
-            if (!(Bitboards::files[file(from)] & pos.getBitboard(c, Piece::Pawn)))
+            if (pawnEntry.isSemiOpenFile(!c, file(from)))
             {
-                if (!(Bitboards::files[file(from)] & pos.getBitboard(!c, Piece::Pawn)))
-                {
-                    scoreOpForColor += 26;
-                }
-                else
-                {
-                    scoreOpForColor += 13;
-                }
+                scoreOpForColor += 26;
+            }
+            else
+            {
+                scoreOpForColor += 13;
             }
         }
+    }
 
-        tempPiece = pos.getBitboard(c, Piece::Queen);
-        while (tempPiece)
-        {
-            const auto from = Bitboards::popLsb(tempPiece);
-            const auto tempMove = Bitboards::queenAttacks(from, occupied) & targetBitboard;
-            const auto count = Bitboards::popcnt<hardwarePopcnt>(tempMove);
-            scoreOpForColor += mobilityOpening[Piece::Queen][count];
-            scoreEdForColor += mobilityEnding[Piece::Queen][count];
-            attackUnits += attackWeight[Piece::Queen] * Bitboards::popcnt<hardwarePopcnt>(tempMove & opponentKingZone);
-        }
-        
-        kingSafetyScore[c] = attackUnits;
-        scoreOp += (c ? -scoreOpForColor : scoreOpForColor);
-        scoreEd += (c ? -scoreEdForColor : scoreEdForColor);
+    tempPiece = pos.getBitboard(c, Piece::Queen);
+    while (tempPiece)
+    {
+        const auto from = Bitboards::popLsb(tempPiece);
+        const auto tempMove = Bitboards::queenAttacks(from, occupied) & targetBitboard;
+        const auto count = Bitboards::popcnt<hardwarePopcnt>(tempMove);
+        scoreOpForColor += mobilityOpening[Piece::Queen][count];
+        scoreEdForColor += mobilityEnding[Piece::Queen][count];
+        attackUnits += attackWeight[Piece::Queen] * Bitboards::popcnt<hardwarePopcnt>(tempMove & opponentKingZone);
     }
 
-    return interpolateScore(scoreOp, scoreEd, phase);
+    kingSafetyScore = attackUnits;
+    scoreOp += (c ? -scoreOpForColor : scoreOpForColor);
+    scoreEd += (c ? -scoreEdForColor : scoreEdForColor);
 }
 
-int Evaluation::pawnStructureEval(const Position& pos, int phase)
+// Sums up the per-file penalties (or bonuses) of a set of pawns. 
+template <bool hardwarePopcnt>
+int scoreByFile(Bitboard pawns, const std::array<int, 8>& table)
 {
+    auto score = 0;
+
+    for (auto f = 0; pawns && f < 8; ++f)
+    {
+        score += table[f] * Bitboards::popcnt<hardwarePopcnt>(pawns & Bitboards::files[f]);
+        pawns &= ~Bitboards::files[f];
+    }
+
+    return score;
+}
+
+// Sums up the per-rank bonuses of a set of pawns. The rank is relative to the color of the pawns.
+template <bool hardwarePopcnt, int8_t c>
+int scoreByRank(Bitboard pawns, const std::array<int, 8>& table)
+{
+    auto score = 0;
+
+    for (auto r = 0; pawns && r < 8; ++r)
+    {
+        const auto rankMask = Bitboards::ranks[c ? 7 - r : r];
+        score += table[r] * Bitboards::popcnt<hardwarePopcnt>(pawns & rankMask);
+        pawns &= ~rankMask;
+    }
+
+    return score;
+}
+
+int evaluatePawnShelter(Bitboard ownPawns, Bitboard enemyPawns, Color side, int kingFile)
+{
+    static const std::array<int, 8> openFilePenalty = { 6, 5, 4, 4, 4, 4, 5, 6 };
+    static const std::array<int, 8> halfopenFilePenalty = { 5, 4, 3, 3, 3, 3, 4, 5 };
+    static const std::array<int, 8> pawnStormPenalty = { 0, 0, 0, 1, 2, 3, 0, 0 };
+
+    auto penalty = 0;
+    // If the king is at the edge assume that it is a bit closer to the center.
+    // This prevents all bugs related to the next loop and going off the board.
+    kingFile = clamp(kingFile, 1, 6);
+
+    for (auto f = kingFile - 1; f <= kingFile + 1; ++f)
+    {
+        const auto own = Bitboards::files[f] & ownPawns;
+        const auto opponent = Bitboards::files[f] & enemyPawns;
+        penalty += (own | opponent) ? 0 : openFilePenalty[f];
+        penalty += (!own && opponent) ? halfopenFilePenalty[f] : 0;
+        penalty += opponent ? pawnStormPenalty[side ? rank(Bitboards::msb(opponent)) : 7 - rank(Bitboards::lsb(opponent))] : 0;
+    }
+
+    return penalty;
+}
+
+template <bool hardwarePopcnt>
+const PawnHashTable::PawnHashTableEntry& Evaluation::pawnStructureEval(const Position& pos)
+{
+    const auto hashEntry = mPawnHashTable.probe(pos.getPawnHashKey());
+    if (SearchStatistics::enabled)
+    {
+        ++mPawnHashTableProbes;
+        mPawnHashTableHits += (hashEntry != nullptr);
+    }
+    if (hashEntry)
+    {
+        return *hashEntry;
+    }
+
+    PawnHashTable::PawnHashTableEntry entry;
     auto scoreOp = 0, scoreEd = 0;
+    const std::array<Bitboard, 2> pawnAttacks = {
+        Bitboards::allPawnAttacks(Color::White, pos.getBitboard(Color::White, Piece::Pawn)),
+        Bitboards::allPawnAttacks(Color::Black, pos.getBitboard(Color::Black, Piece::Pawn))
+    };
 
-    if (mPawnHashTable.probe(pos.getPawnHashKey(), scoreOp, scoreEd))
+    pawnStructureEvalForColor<hardwarePopcnt, Color::White>(pos, pawnAttacks, entry, scoreOp, scoreEd);
+    pawnStructureEvalForColor<hardwarePopcnt, Color::Black>(pos, pawnAttacks, entry, scoreOp, scoreEd);
+
+    assert(verifyPawnStructure(pos, scoreOp, scoreEd));
+
+    entry.setScores(scoreOp, scoreEd);
+
+    return *mPawnHashTable.save(pos.getPawnHashKey(), entry);
+}
+
+template <bool hardwarePopcnt, int8_t c>
+void Evaluation::pawnStructureEvalForColor(const Position& pos, const std::array<Bitboard, 2>& pawnAttacks, PawnHashTable::PawnHashTableEntry& entry, int& scoreOp, int& scoreEd)
+{
+    // All pawns are evaluated at once with fills instead of looping over them one by one.
+    const auto allPawns = pos.getBitboard(Color::White, Piece::Pawn) | pos.getBitboard(Color::Black, Piece::Pawn);
+    const auto ownPawns = pos.getBitboard(c, Piece::Pawn);
+    const auto opponentPawns = pos.getBitboard(!c, Piece::Pawn);
+    const auto ownAdjacent = Bitboards::eastOne(ownPawns) | Bitboards::westOne(ownPawns);
+    const auto opponentAdjacent = Bitboards::eastOne(opponentPawns) | Bitboards::westOne(opponentPawns);
+    // Stop-squares which are not blocked by a pawn but are controlled by an enemy pawn, shifted back to the pawns they belong to.
+    const auto stopSquares = pawnAttacks[!c] & ~allPawns;
+    const auto unsafeStops = (c ? stopSquares << 8 : stopSquares >> 8);
+
+    const auto passed = ownPawns & ~Bitboards::frontSpan(!c, opponentPawns | opponentAdjacent);
+    const auto doubled = ownPawns & Bitboards::frontSpan(!c, ownPawns);
+    const auto isolated = ownPawns & ~Bitboards::fileFill(ownAdjacent);
+    // 1. There musn't be any own pawns capable of defending the pawn. 
+    // 2. The pawn mustn't be blocked by a pawn.
+    // 3. The stop-square of the pawn must be controlled by an enemy pawn.
+    const auto backward = ownPawns & ~(ownAdjacent | Bitboards::frontSpan(c, ownAdjacent)) & unsafeStops;
+
+    const auto scoreOpForColor = scoreByRank<hardwarePopcnt, c>(passed, passedBonusOpening)
+                               - scoreByFile<hardwarePopcnt>(doubled, doubledPenaltyOpening)
+                               - scoreByFile<hardwarePopcnt>(isolated, isolatedPenaltyOpening)
+                               - scoreByFile<hardwarePopcnt>(backward, backwardPenaltyOpening);
+    const auto scoreEdForColor = scoreByRank<hardwarePopcnt, c>(passed, passedBonusEnding)
+                               - scoreByFile<hardwarePopcnt>(doubled, doubledPenaltyEnding)
+                               - scoreByFile<hardwarePopcnt>(isolated, isolatedPenaltyEnding)
+                               - scoreByFile<hardwarePopcnt>(backward, backwardPenaltyEnding);
+
+    scoreOp += (c ? -scoreOpForColor : scoreOpForColor);
+    scoreEd += (c ? -scoreEdForColor : scoreEdForColor);
+
+    // The rest of the information only depends on the pawns as well so we might as well store it while we are at it.
+    // The first rank of a file fill has the bit of every file containing a pawn set.
+    entry.setSemiOpenFiles(c, static_cast<uint8_t>(~Bitboards::fileFill(ownPawns)));
+    for (auto f = 0; f < 8; ++f)
     {
-        return interpolateScore(scoreOp, scoreEd, phase);
+        entry.setKingShelter(c, f, evaluatePawnShelter(ownPawns, opponentPawns, c, f));
+    }
+}
+
+int Evaluation::kingSafetyEval(const Position& pos, const PawnHashTable::PawnHashTableEntry& pawnEntry, int phase, std::array<int, 2>& kingSafetyScore)
+{
+    kingSafetyScore[Color::Black] += pawnEntry.getKingShelter(Color::White, file(Bitboards::lsb(pos.getBitboard(Color::White, Piece::King))));
+    kingSafetyScore[Color::White] += pawnEntry.getKingShelter(Color::Black, file(Bitboards::lsb(pos.getBitboard(Color::Black, Piece::King))));
+    kingSafetyScore[Color::White] = std::min(kingSafetyScore[Color::White], 99);
+    kingSafetyScore[Color::Black] = std::min(kingSafetyScore[Color::Black], 99);
+
+    const auto score = kingSafetyTable[kingSafetyScore[Color::White]] - kingSafetyTable[kingSafetyScore[Color::Black]];
+    return ((score * (64 - phase)) / 64);
+}
+
+bool Evaluation::checkPawnStructure(const Position& pos)
+{
+    const std::array<Bitboard, 2> pawnAttacks = {
+        Bitboards::allPawnAttacks(Color::White, pos.getBitboard(Color::White, Piece::Pawn)),
+        Bitboards::allPawnAttacks(Color::Black, pos.getBitboard(Color::Black, Piece::Pawn))
+    };
+
+    // Check both popcount versions, the one not used by the machine would go untested otherwise.
+    for (auto hardwarePopcnt = 0; hardwarePopcnt <= static_cast<int>(Bitboards::hardwarePopcntSupported()); ++hardwarePopcnt)
+    {
+        PawnHashTable::PawnHashTableEntry entry;
+        auto scoreOp = 0, scoreEd = 0;
+        if (hardwarePopcnt)
+        {
+            pawnStructureEvalForColor<true, Color::White>(pos, pawnAttacks, entry, scoreOp, scoreEd);
+            pawnStructureEvalForColor<true, Color::Black>(pos, pawnAttacks, entry, scoreOp, scoreEd);
+        }
+        else
+        {
+            pawnStructureEvalForColor<false, Color::White>(pos, pawnAttacks, entry, scoreOp, scoreEd);
+            pawnStructureEvalForColor<false, Color::Black>(pos, pawnAttacks, entry, scoreOp, scoreEd);
+        }
+
+        if (!verifyPawnStructure(pos, scoreOp, scoreEd))
+        {
+            return false;
+        }
     }
 
+    return true;
+}
+
+bool Evaluation::verifyPawnStructure(const Position& pos, int scoreOp, int scoreEd)
+{
+    // The straightforward pawn-by-pawn version of pawnStructureEval, used for checking that the set-wise version is correct.
+    auto correctScoreOp = 0, correctScoreEd = 0;
+
     for (Color c = Color::White; c <= Color::Black; ++c)
     {
         const auto ownPawns = pos.getBitboard(c, Piece::Pawn);
@@ -291,85 +518,38 @@ int Evaluation::pawnStructureEval(const Position& pos, int phase)
         {
             const auto from = Bitboards::popLsb(tempPawns);
             const auto pawnFile = file(from);
-            const auto pawnRank = (c ? 7 - rank(from) : rank(from)); // rank is relative to side to move
-
-            const auto passed = !(opponentPawns & Bitboards::passedPawn(c, from));
-            const auto doubled = (ownPawns & (c ? Bitboards::ray(1, from) : Bitboards::ray(6, from))) != 0;
-            const auto isolated = !(ownPawns & Bitboards::isolatedPawn(from));
-            // 1. There musn't be any own pawns capable of defending the pawn. 
-            // 2. The pawn mustn't be blocked by a pawn.
-            // 3. The stop-square of the pawn must be controlled by an enemy pawn.
-            const auto backward = !(ownPawns & Bitboards::backwardPawn(c, from))
-                               && pos.getBoard(from + 8 - 16 * c) != Piece::WhitePawn && pos.getBoard(from + 8 - 16 * c) != Piece::BlackPawn
-                               && (Bitboards::pawnAttacks(c, from + 8 - 16 * c) & opponentPawns);
-
-            if (passed)
+            const auto pawnRank = (c ? 7 - rank(from) : rank(from));
+
+            if (!(opponentPawns & Bitboards::passedPawn(c, from)))
             {
                 scoreOpForColor += passedBonusOpening[pawnRank];
                 scoreEdForColor += passedBonusEnding[pawnRank];
             }
 
-            if (doubled)
+            if (ownPawns & (c ? Bitboards::ray(1, from) : Bitboards::ray(6, from)))
             {
                 scoreOpForColor -= doubledPenaltyOpening[pawnFile];
                 scoreEdForColor -= doubledPenaltyEnding[pawnFile];
             }
 
-            if (isolated)
+            if (!(ownPawns & Bitboards::isolatedPawn(from)))
             {
                 scoreOpForColor -= isolatedPenaltyOpening[pawnFile];
                 scoreEdForColor -= isolatedPenaltyEnding[pawnFile];
             }
 
-            if (backward)
+            if (!(ownPawns & Bitboards::backwardPawn(c, from))
+                && pos.getBoard(from + 8 - 16 * c) != Piece::WhitePawn && pos.getBoard(from + 8 - 16 * c) != Piece::BlackPawn
+                && (Bitboards::pawnAttacks(c, from + 8 - 16 * c) & opponentPawns))
             {
                 scoreOpForColor -= backwardPenaltyOpening[pawnFile];
                 scoreEdForColor -= backwardPenaltyEnding[pawnFile];
             }
         }
 
-        scoreOp += (c == Color::Black ? -scoreOpForColor : scoreOpForColor);
-        scoreEd += (c == Color::Black ? -scoreEdForColor : scoreEdForColor);
+        correctScoreOp += (c == Color::Black ? -scoreOpForColor : scoreOpForColor);
+        correctScoreEd += (c == Color::Black ? -scoreEdForColor : scoreEdForColor);
     }
 
-    mPawnHashTable.save(pos.getPawnHashKey(), scoreOp, scoreEd);
-
-    return interpolateScore(scoreOp, scoreEd, phase);
-}
-
-int evaluatePawnShelter(const Position& pos, Color side)
-{
-    static const std::array<int, 8> openFilePenalty = { 6, 5, 4, 4, 4, 4, 5, 6 };
-    static const std::array<int, 8> halfopenFilePenalty = { 5, 4, 3, 3, 3, 3, 4, 5 };
-    static const std::array<int, 8> pawnStormPenalty = { 0, 0, 0, 1, 2, 3, 0, 0 };
-
-    auto penalty = 0;
-    const auto ownPawns = pos.getBitboard(side, Piece::Pawn);
-    const auto enemyPawns = pos.getBitboard(!side, Piece::Pawn);
-    // If the king is at the edge assume that it is a bit closer to the center.
-    // This prevents all bugs related to the next loop and going off the board.
-    const auto kingFile = clamp(file(Bitboards::lsb(pos.getBitboard(side, Piece::King))), 1, 6);
-
-    for (auto f = kingFile - 1; f <= kingFile + 1; ++f)
-    {
-        const auto own = Bitboards::files[f] & ownPawns;
-        const auto opponent = Bitboards::files[f] & enemyPawns;
-
-        penalty += (own | opponent) ? 0 : openFilePenalty[f];
-        penalty += (!own && opponent) ? halfopenFilePenalty[f] : 0;
-        penalty += opponent ? pawnStormPenalty[side ? rank(Bitboards::msb(opponent)) : 7 - rank(Bitboards::lsb(opponent))] : 0;
-    }
-
-    return penalty;
-}
-
-int Evaluation::kingSafetyEval(const Position& pos, int phase, std::array<int, 2>& kingSafetyScore)
-{
-    kingSafetyScore[Color::Black] += evaluatePawnShelter(pos, Color::White);
-    kingSafetyScore[Color::White] += evaluatePawnShelter(pos, Color::Black);
-    kingSafetyScore[Color::White] = std::min(kingSafetyScore[Color::White], 99);
-    kingSafetyScore[Color::Black] = std::min(kingSafetyScore[Color::Black], 99);
-
-    const auto score = kingSafetyTable[kingSafetyScore[Color::White]] - kingSafetyTable[kingSafetyScore[Color::Black]];
-    return ((score * (64 - phase)) / 64);
+    return (scoreOp == correctScoreOp && scoreEd == correctScoreEd);
 }
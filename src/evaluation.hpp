@@ -22,23 +22,61 @@
 #define EVALUATION_HPP_
 
 #include <array>
+#include <string>
+#include <vector>
 #include "position.hpp"
 #include "zobrist.hpp"
 #include "endgame.hpp"
 #include "pht.hpp"
+#include "search_statistics.hpp"
 
 /// @brief The evaluation function.
 class Evaluation
 {
 public:
+    /// @brief Default constructor.
+    Evaluation();
+
     /// @brief Initializes the class, must be called before using any other methods.
+    ///
+    /// Must also be called again after changing the parameters, as the PSTs are calculated from them.
     static void staticInitialize();
 
+    /// @brief A named group of parameters of the evaluation function, for example a single PST.
+    struct ParameterGroup
+    {
+        std::string mName;
+        std::vector<int*> mValues;
+    };
+
+    /// @brief Get the parameters of the evaluation function for tuning.
+    /// @return The parameters in groups. The pointers can be used for changing the parameters.
+    ///
+    /// Changing the parameters while a search is running is not allowed. 
+    /// The pawn hash table contains scores calculated with the old parameters so it must be cleared after changing them.
+    static std::vector<ParameterGroup> getParameterGroups();
+
     /// @brief Evaluates a given position.
     /// @param pos The position.
     /// @return The heuristic score given to the position.
     int evaluate(const Position& pos);
 
+    /// @brief Checks that the pawn structure evaluation agrees with a straightforward pawn-by-pawn version of it. Used for testing.
+    /// @param pos The position.
+    /// @return True if both versions give the same scores, false otherwise.
+    static bool checkPawnStructure(const Position& pos);
+
+    /// @brief Get the number of pawn hash table probes. Only counted if search statistics are enabled.
+    /// @return The number of probes.
+    uint64_t getPawnHashTableProbes() const;
+
+    /// @brief Get the number of succesful pawn hash table probes. Only counted if search statistics are enabled.
+    /// @return The number of hits.
+    uint64_t getPawnHashTableHits() const;
+
+    /// @brief Resets the pawn hash table counters to zero.
+    void resetStatistics();
+
     /// @brief Clears the pawn hash table used by the evalation function.
     void clearPawnHashTable();
 
@@ -46,6 +84,10 @@ public:
     /// @param sizeInMegaBytes The new size in megabytes.
     void setPawnHashTableSize(size_t sizeInMegaBytes);
 
+    /// @brief Load the pawn hash table entry of a given pawn hash key into the cache. Used as a speed optimization.
+    /// @param phk The pawn hash key.
+    void prefetchPawnHashTable(HashKey phk) const;
+
     /// @brief Get the opening PST score of a given piece on a given square.
     /// @param p The piece.
     /// @param sq The square.
@@ -61,6 +103,8 @@ public:
 private:
     EndgameModule mEndgameModule;
     PawnHashTable mPawnHashTable;
+    uint64_t mPawnHashTableProbes;
+    uint64_t mPawnHashTableHits;
 
     // These two have to be annoyingly static, as we use them in position.cpp to incrementally update the PST eval.
     static std::array<std::array<short, 64>, 12> mPieceSquareTableOpening;
@@ -70,13 +114,41 @@ private:
     int evaluate(const Position& pos);
 
     template <bool hardwarePopcnt> 
-    int mobilityEval(const Position& pos, std::array<int, 2>& kingSafetyScore, int phase);
+    int mobilityEval(const Position& pos, const PawnHashTable::PawnHashTableEntry& pawnEntry, std::array<int, 2>& kingSafetyScore, int phase);
+
+    // The per-color parts of the evaluation are templated on the color so that shifts, rank flips and signs are resolved at compile time.
+    template <bool hardwarePopcnt, int8_t c> 
+    static void mobilityEvalForColor(const Position& pos, const PawnHashTable::PawnHashTableEntry& pawnEntry, int& kingSafetyScore, int& scoreOp, int& scoreEd);
+
+    // Returns the pawn hash table entry of the position, calculating it first if necessary.
+    template <bool hardwarePopcnt> 
+    const PawnHashTable::PawnHashTableEntry& pawnStructureEval(const Position& pos);
+
+    template <bool hardwarePopcnt, int8_t c> 
+    static void pawnStructureEvalForColor(const Position& pos, const std::array<Bitboard, 2>& pawnAttacks, PawnHashTable::PawnHashTableEntry& entry, int& scoreOp, int& scoreEd);
 
-    int pawnStructureEval(const Position& pos, int phase);
+    // Debugging function, checks the set-wise pawn evaluation against a slow pawn-by-pawn version.
+    static bool verifyPawnStructure(const Position& pos, int scoreOp, int scoreEd);
     // Static to get around a static analysis tool warning.
-    static int kingSafetyEval(const Position& pos, int phase, std::array<int, 2>& kingSafetyScore);
+    static int kingSafetyEval(const Position& pos, const PawnHashTable::PawnHashTableEntry& pawnEntry, int phase, std::array<int, 2>& kingSafetyScore);
 };
 
+inline uint64_t Evaluation::getPawnHashTableProbes() const
+{
+    return mPawnHashTableProbes;
+}
+
+inline uint64_t Evaluation::getPawnHashTableHits() const
+{
+    return mPawnHashTableHits;
+}
+
+inline void Evaluation::resetStatistics()
+{
+    mPawnHashTableProbes = 0;
+    mPawnHashTableHits = 0;
+}
+
 inline void Evaluation::clearPawnHashTable()
 {
     mPawnHashTable.clear();
@@ -87,6 +159,11 @@ inline void Evaluation::setPawnHashTableSize(size_t sizeInMegaBytes)
     mPawnHashTable.setSize(sizeInMegaBytes);
 }
 
+inline void Evaluation::prefetchPawnHashTable(HashKey phk) const
+{
+    mPawnHashTable.prefetch(phk);
+}
+
 inline short Evaluation::getPieceSquareTableOp(Piece p, Square sq)
 {
     return mPieceSquareTableOpening[p][sq];
@@ -16,6 +16,8 @@
 */
 
 #include "history.hpp"
+#include <istream>
+#include <ostream>
 
 HistoryTable::HistoryTable()
 {
@@ -66,3 +68,21 @@ void HistoryTable::age()
     }
 }
 
+bool HistoryTable::save(std::ostream& out) const
+{
+    out.write(reinterpret_cast<const char*>(&mHistory), sizeof(mHistory));
+    out.write(reinterpret_cast<const char*>(&mButterfly), sizeof(mButterfly));
+    return static_cast<bool>(out);
+}
+
+bool HistoryTable::load(std::istream& in)
+{
+    in.read(reinterpret_cast<char*>(&mHistory), sizeof(mHistory));
+    in.read(reinterpret_cast<char*>(&mButterfly), sizeof(mButterfly));
+    if (!in)
+    {
+        clear();
+        return false;
+    }
+    return true;
+}
@@ -22,6 +22,7 @@
 #define HISTORY_HPP_
 
 #include <array>
+#include <iosfwd>
 #include "move.hpp"
 #include "position.hpp"
 
@@ -56,6 +57,16 @@ public:
     /// @brief Ages the history table so that scores for previous positions won't dominate.
     void age();
 
+    /// @brief Writes the history table to a stream.
+    /// @param out The stream, must be opened in binary mode.
+    /// @return True if succesful.
+    bool save(std::ostream& out) const;
+
+    /// @brief Reads a history table written by save from a stream.
+    /// @param in The stream, must be opened in binary mode.
+    /// @return True if succesful. On failure the table is cleared.
+    bool load(std::istream& in);
+
 private:
     std::array<std::array<int, 64>, 12> mHistory;
     std::array<std::array<int, 64>, 12> mButterfly;
@@ -0,0 +1,233 @@
+/*
+    Hakkapeliitta - A UCI chess engine. Copyright (C) 2013-2015 Mikko Aarnos.
+
+    Hakkapeliitta is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Hakkapeliitta is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Hakkapeliitta. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "mate_search.hpp"
+#include <algorithm>
+#include "constants.hpp"
+#include "movegen.hpp"
+#include "utils/exception.hpp"
+
+// 2^20 entries of 16 bytes each, plenty for the short mates this is meant for.
+const size_t tableSize = static_cast<size_t>(1) << 20;
+
+MateSearch::MateSearch() :
+    mNodeCount(0)
+{
+}
+
+void MateSearch::clear()
+{
+    std::fill(mTable.begin(), mTable.end(), Entry());
+}
+
+MateSearch::Entry& MateSearch::getEntry(HashKey hk)
+{
+    // Always replace, a lost result is simply searched again.
+    auto& entry = mTable[hk & (mTable.size() - 1)];
+    if (entry.mKey != hk)
+    {
+        entry = Entry();
+        entry.mKey = hk;
+    }
+    return entry;
+}
+
+std::vector<Move> MateSearch::solve(const Position& root, int maxMoves, const std::function<bool(uint64_t)>& stop)
+{
+    if (mTable.empty())
+    {
+        mTable.resize(tableSize);
+    }
+    mNodeCount = 0;
+    mStop = stop;
+
+    try
+    {
+        for (auto moves = 1; moves <= std::min(maxMoves, maxPly / 2); ++moves)
+        {
+            if (attackerWins(root, moves))
+            {
+                return extractPv(root, moves);
+            }
+        }
+    }
+    catch (const StopSearchException&)
+    {
+    }
+
+    return std::vector<Move>();
+}
+
+bool MateSearch::attackerWins(const Position& pos, int movesLeft)
+{
+    if ((++mNodeCount & 1023) == 0 && mStop(mNodeCount))
+    {
+        throw StopSearchException("ordered to stop");
+    }
+
+    {
+        const auto& entry = getEntry(pos.getHashKey());
+        if (entry.mWinIn && entry.mWinIn <= movesLeft)
+        {
+            return true;
+        }
+        if (entry.mNoWinIn >= movesLeft)
+        {
+            return false;
+        }
+    }
+
+    const auto inCheck = pos.inCheck();
+    MoveList moveList;
+    if (inCheck)
+    {
+        MoveGen::generateLegalEvasions(pos, moveList);
+    }
+    else
+    {
+        // The check generator is not used for the last move, it misses castling checks and checking underpromotions.
+        // Non-checking moves are filtered out below instead.
+        MoveGen::generatePseudoLegalMoves(pos, moveList);
+    }
+
+    // Checks first, then captures, then the rest. Checks leave the opponent the fewest replies.
+    std::vector<std::pair<int, Move>> moves;
+    for (auto i = 0; i < moveList.size(); ++i)
+    {
+        const auto move = moveList.getMove(i);
+        const auto givesCheck = pos.givesCheck(move) != 0;
+        if ((movesLeft == 1 && !givesCheck) || !pos.legal(move, inCheck))
+        {
+            continue;
+        }
+        moves.emplace_back(-(2 * givesCheck + pos.captureOrPromotion(move)), move);
+    }
+    std::stable_sort(moves.begin(), moves.end(), [](const std::pair<int, Move>& a, const std::pair<int, Move>& b) { return a.first < b.first; });
+
+    for (auto& scoredMove : moves)
+    {
+        Position newPosition(pos);
+        newPosition.makeMove(scoredMove.second);
+        if (defenderLoses(newPosition, movesLeft))
+        {
+            auto& entry = getEntry(pos.getHashKey());
+            entry.mWinIn = static_cast<int8_t>(movesLeft);
+            entry.mMove = scoredMove.second.getRawMove();
+            return true;
+        }
+    }
+
+    auto& entry = getEntry(pos.getHashKey());
+    entry.mNoWinIn = static_cast<int8_t>(std::max(static_cast<int>(entry.mNoWinIn), movesLeft));
+    return false;
+}
+
+bool MateSearch::defenderLoses(const Position& pos, int movesLeft)
+{
+    ++mNodeCount;
+
+    const auto inCheck = pos.inCheck();
+    MoveList moveList;
+    inCheck ? MoveGen::generateLegalEvasions(pos, moveList) : MoveGen::generatePseudoLegalMoves(pos, moveList);
+
+    // Captures first, they are the most likely to refute the mate.
+    std::vector<std::pair<int, Move>> moves;
+    for (auto i = 0; i < moveList.size(); ++i)
+    {
+        const auto move = moveList.getMove(i);
+        if (!pos.legal(move, inCheck))
+        {
+            continue;
+        }
+
+        // Any legal move escapes if the mating side has run out of moves.
+        if (movesLeft == 1)
+        {
+            return false;
+        }
+        moves.emplace_back(-pos.captureOrPromotion(move), move);
+    }
+    std::stable_sort(moves.begin(), moves.end(), [](const std::pair<int, Move>& a, const std::pair<int, Move>& b) { return a.first < b.first; });
+
+    for (auto& scoredMove : moves)
+    {
+        Position newPosition(pos);
+        newPosition.makeMove(scoredMove.second);
+        if (!attackerWins(newPosition, movesLeft - 1))
+        {
+            return false;
+        }
+    }
+
+    // Every move loses, unless there were none. Then it is either checkmate or stalemate.
+    return !moves.empty() || inCheck;
+}
+
+std::vector<Move> MateSearch::extractPv(const Position& root, int movesLeft)
+{
+    std::vector<Move> pv;
+    auto pos = root;
+
+    for (; movesLeft > 0; --movesLeft)
+    {
+        // The entry might have been overwritten, searching again restores it.
+        if (!attackerWins(pos, movesLeft))
+        {
+            break;
+        }
+        const Move move(getEntry(pos.getHashKey()).mMove);
+        pv.push_back(move);
+        pos.makeMove(move);
+
+        // The defender plays the move which delays the mate the longest.
+        const auto inCheck = pos.inCheck();
+        MoveList moveList;
+        inCheck ? MoveGen::generateLegalEvasions(pos, moveList) : MoveGen::generatePseudoLegalMoves(pos, moveList);
+        Move bestReply;
+        auto longestMate = 0;
+        for (auto i = 0; i < moveList.size(); ++i)
+        {
+            const auto reply = moveList.getMove(i);
+            if (!pos.legal(reply, inCheck))
+            {
+                continue;
+            }
+
+            Position newPosition(pos);
+            newPosition.makeMove(reply);
+            auto mateIn = 1;
+            while (mateIn < movesLeft - 1 && !attackerWins(newPosition, mateIn))
+            {
+                ++mateIn;
+            }
+            if (mateIn > longestMate)
+            {
+                longestMate = mateIn;
+                bestReply = reply;
+            }
+        }
+
+        if (bestReply.empty())
+        {
+            break;
+        }
+        pv.push_back(bestReply);
+        pos.makeMove(bestReply);
+    }
+
+    return pv;
+}
@@ -0,0 +1,90 @@
+/*
+    Hakkapeliitta - A UCI chess engine. Copyright (C) 2013-2015 Mikko Aarnos.
+
+    Hakkapeliitta is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Hakkapeliitta is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Hakkapeliitta. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/// @file mate_search.hpp
+/// @author Mikko Aarnos
+
+#ifndef MATE_SEARCH_HPP_
+#define MATE_SEARCH_HPP_
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "move.hpp"
+#include "position.hpp"
+#include "zobrist.hpp"
+
+/// @brief A search dedicated to proving forced mates, used for "go mate".
+///
+/// The search is a plain depth-limited AND-OR search deepened one move at a time, so the first mate found is the shortest one.
+/// Unlike the normal search there is no evaluation, pruning or reductions, so a mate found is a proven mate and a mate not found does not exist.
+/// The moves of the mating side are tried checks first. On its last move only checks are tried, as only they can mate.
+/// Repetitions and the fifty-move rule are ignored, they can't matter for the short mates this is meant for.
+///
+/// The results are cached in a table of its own, separate from the transposition table of the normal search.
+class MateSearch
+{
+public:
+    /// @brief Default constructor. The table is only allocated when it is first needed.
+    MateSearch();
+
+    /// @brief Tries to find a forced mate from a given position.
+    /// @param root The position.
+    /// @param maxMoves The maximum amount of moves of the side to move in the mate.
+    /// @param stop Called every few thousand nodes with the amount of nodes searched so far, returns true if the search must stop.
+    /// @return The mating line, empty if there is no mate in maxMoves or if the search was stopped.
+    std::vector<Move> solve(const Position& root, int maxMoves, const std::function<bool(uint64_t)>& stop);
+
+    /// @brief Get the amount of nodes searched by the last call to solve.
+    /// @return The amount of nodes.
+    uint64_t getNodeCount() const noexcept;
+
+    /// @brief Clears the table.
+    void clear();
+
+private:
+    // Stores what is known about a position with the mating side to move.
+    // A win in mWinIn moves has been proven, and it has been proven that there is no win in mNoWinIn moves, zero meaning not known.
+    struct Entry
+    {
+        HashKey mKey;
+        uint16_t mMove;
+        int8_t mWinIn;
+        int8_t mNoWinIn;
+    };
+
+    std::vector<Entry> mTable;
+    uint64_t mNodeCount;
+    std::function<bool(uint64_t)> mStop;
+
+    Entry& getEntry(HashKey hk);
+
+    // Checks whether the side to move can mate in at most movesLeft moves.
+    bool attackerWins(const Position& pos, int movesLeft);
+
+    // Checks whether every move of the side to move leads to a position where the opponent can mate in at most movesLeft - 1 moves.
+    bool defenderLoses(const Position& pos, int movesLeft);
+
+    std::vector<Move> extractPv(const Position& root, int movesLeft);
+};
+
+inline uint64_t MateSearch::getNodeCount() const noexcept
+{
+    return mNodeCount;
+}
+
+#endif
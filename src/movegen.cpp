@@ -18,7 +18,7 @@
 #include "movegen.hpp"
 #include <iostream>
 
-void addPieceMovesFromMask(MoveList& moveList, Bitboard mask, Square from)
+void addPieceMovesFromMask(MoveSpan& moveList, Bitboard mask, Square from)
 {
     while (mask)
     {
@@ -27,13 +27,14 @@ void addPieceMovesFromMask(MoveList& moveList, Bitboard mask, Square from)
     }
 }
 
-void addPawnSingleMovesFromMask(MoveList& moveList, Bitboard mask, bool underPromotions, Color side)
+template <int8_t side>
+void addPawnSingleMovesFromMask(MoveSpan& moveList, Bitboard mask, bool underPromotions)
 {
     while (mask)
     {
         const auto to = Bitboards::popLsb(mask);
         const auto from = to - 8 + side * 16;
-        if (to >= Square::A8 || to <= Square::H1)
+        if (side ? to <= Square::H1 : to >= Square::A8)
         {
             moveList.emplace_back(from, to, Piece::Queen);
             if (underPromotions)
@@ -50,7 +51,8 @@ void addPawnSingleMovesFromMask(MoveList& moveList, Bitboard mask, bool underPro
     }
 }
 
-void addPawnDoubleMovesFromMask(MoveList& moveList, Bitboard mask, Color side)
+template <int8_t side>
+void addPawnDoubleMovesFromMask(MoveSpan& moveList, Bitboard mask)
 {
     while (mask)
     {
@@ -60,8 +62,8 @@ void addPawnDoubleMovesFromMask(MoveList& moveList, Bitboard mask, Color side)
     }
 }
 
-template <bool rightCaptures>
-void addPawnCapturesFromMask(MoveList& moveList, Bitboard mask, Square ep, bool underPromotions, Color side)
+template <int8_t side, bool rightCaptures>
+void addPawnCapturesFromMask(MoveSpan& moveList, Bitboard mask, Square ep, bool underPromotions)
 {
     while (mask)
     {
@@ -71,7 +73,7 @@ void addPawnCapturesFromMask(MoveList& moveList, Bitboard mask, Square ep, bool
         {
             moveList.emplace_back(from, to, Piece::Pawn);
         }
-        else if (to >= Square::A8 || to <= Square::H1)
+        else if (side ? to <= Square::H1 : to >= Square::A8)
         {
             moveList.emplace_back(from, to, Piece::Queen);
             if (underPromotions)
@@ -88,37 +90,85 @@ void addPawnCapturesFromMask(MoveList& moveList, Bitboard mask, Square ep, bool
     }
 }
 
-void MoveGen::generatePseudoLegalMoves(const Position& pos, MoveList& moveList)
+// The squares a piece can move to without exposing its king: all of them, unless the piece is pinned in which case only the line through the king.
+Bitboard pinRay(Bitboard pinned, Square kingSquare, Square from)
 {
-    const auto side = pos.getSideToMove();
+    return Bitboards::testBit(pinned, from) ? Bitboards::lineFormedBySquares(kingSquare, from) : ~0ULL;
+}
+
+// Removes the squares attacked by the opponent from the targets of the king.
+template <int8_t side>
+Bitboard safeKingTargets(const Position& pos, Bitboard targets)
+{
+    auto safeTargets = targets;
+    while (targets)
+    {
+        const auto to = Bitboards::popLsb(targets);
+        if (pos.isAttacked(to, !side))
+        {
+            Bitboards::clearBit(safeTargets, to);
+        }
+    }
+    return safeTargets;
+}
+
+// Removes the illegal moves among the pawn moves starting at a given index.
+// Pinned pawns and en passant captures are rare, so checking them afterwards is cheaper than generating the moves of those pawns one by one.
+void removeIllegalPawnMoves(const Position& pos, MoveSpan& moveList, int first)
+{
+    auto last = first;
+    for (auto i = first; i < moveList.size(); ++i)
+    {
+        const auto move = moveList.getMove(i);
+        if (pos.legal(move, false))
+        {
+            moveList.setMove(last++, move);
+        }
+    }
+    moveList.resize(last);
+}
+
+template <int8_t side, bool legal>
+void MoveGen::generateMoves(const Position& pos, MoveSpan& moveList)
+{
+    assert(pos.getSideToMove() == side);
+    assert(!legal || !pos.inCheck());
     const auto occupiedSquares = pos.getOccupiedSquares();
     const auto freeSquares = ~occupiedSquares;
     const auto enemyPieces = pos.getPieces(!side);
     const auto targetBB = freeSquares | enemyPieces;
     const auto ep = (pos.getEnPassantSquare() != Square::NoSquare ? Bitboards::bit(pos.getEnPassantSquare()) : 0);
+    const auto pinned = pos.getPinnedPieces();
+    const auto kingSquare = Bitboards::lsb(pos.getBitboard(side, Piece::King));
+    const auto firstPawnMove = moveList.size();
 
     // Pawn moves.
     auto tempPiece = pos.getBitboard(side, Piece::Pawn);
     auto tempMove = (side ? tempPiece >> 8 : tempPiece << 8) & freeSquares;
-    addPawnSingleMovesFromMask(moveList, tempMove, true, side);
+    addPawnSingleMovesFromMask<side>(moveList, tempMove, true);
 
     tempMove = (side ? (tempMove & Bitboards::ranks[5]) >> 8 : (tempMove & Bitboards::ranks[2]) << 8) & freeSquares;
-    addPawnDoubleMovesFromMask(moveList, tempMove, side);
+    addPawnDoubleMovesFromMask<side>(moveList, tempMove);
 
     tempMove = (side ? tempPiece >> 9 : tempPiece << 7) & 0x7F7F7F7F7F7F7F7F & (enemyPieces | ep);
-    addPawnCapturesFromMask<false>(moveList, tempMove, pos.getEnPassantSquare(), true, side);
+    addPawnCapturesFromMask<side, false>(moveList, tempMove, pos.getEnPassantSquare(), true);
 
     tempMove = (side ? tempPiece >> 7 : tempPiece << 9) & 0xFEFEFEFEFEFEFEFE & (enemyPieces | ep);
-    addPawnCapturesFromMask<true>(moveList, tempMove, pos.getEnPassantSquare(), true, side);
+    addPawnCapturesFromMask<side, true>(moveList, tempMove, pos.getEnPassantSquare(), true);
+
+    if (legal && ((tempPiece & pinned) || ep))
+    {
+        removeIllegalPawnMoves(pos, moveList, firstPawnMove);
+    }
 
     // King moves (without castling which is handled later).
-    auto from = Bitboards::lsb(pos.getBitboard(side, Piece::King));
+    auto from = kingSquare;
     tempMove = Bitboards::kingAttacks(from) & targetBB;
-    addPieceMovesFromMask(moveList, tempMove, from);
+    addPieceMovesFromMask(moveList, legal ? safeKingTargets<side>(pos, tempMove) : tempMove, from);
 
     // Knight moves.
     // Since pinned knights do not have legal moves we can remove them.
-    tempPiece = pos.getBitboard(side, Piece::Knight); // & ~pos.getPinnedPieces();
+    tempPiece = pos.getBitboard(side, Piece::Knight) & (legal ? ~pinned : ~0ULL);
     while (tempPiece)
     {
         from = Bitboards::popLsb(tempPiece);
@@ -131,7 +181,7 @@ void MoveGen::generatePseudoLegalMoves(const Position& pos, MoveList& moveList)
     while (tempPiece)
     {
         from = Bitboards::popLsb(tempPiece);
-        tempMove = Bitboards::bishopAttacks(from, occupiedSquares) & targetBB;
+        tempMove = Bitboards::bishopAttacks(from, occupiedSquares) & targetBB & (legal ? pinRay(pinned, kingSquare, from) : ~0ULL);
         addPieceMovesFromMask(moveList, tempMove, from);
     }
     
@@ -140,7 +190,7 @@ void MoveGen::generatePseudoLegalMoves(const Position& pos, MoveList& moveList)
     while (tempPiece)
     {
         from = Bitboards::popLsb(tempPiece);
-        tempMove = Bitboards::rookAttacks(from, occupiedSquares) & targetBB;
+        tempMove = Bitboards::rookAttacks(from, occupiedSquares) & targetBB & (legal ? pinRay(pinned, kingSquare, from) : ~0ULL);
         addPieceMovesFromMask(moveList, tempMove, from);
     }
 
@@ -149,7 +199,7 @@ void MoveGen::generatePseudoLegalMoves(const Position& pos, MoveList& moveList)
     while (tempPiece)
     {
         from = Bitboards::popLsb(tempPiece);
-        tempMove = Bitboards::queenAttacks(from, occupiedSquares) & targetBB;
+        tempMove = Bitboards::queenAttacks(from, occupiedSquares) & targetBB & (legal ? pinRay(pinned, kingSquare, from) : ~0ULL);
         addPieceMovesFromMask(moveList, tempMove, from);
     }
 
@@ -178,12 +228,13 @@ void MoveGen::generatePseudoLegalMoves(const Position& pos, MoveList& moveList)
     }
 }
 
-void MoveGen::generateLegalEvasions(const Position& pos, MoveList& moveList)
+template <int8_t side>
+void MoveGen::generateLegalEvasions(const Position& pos, MoveSpan& moveList)
 {
     assert(pos.inCheck());
+    assert(pos.getSideToMove() == side);
 
     int from;
-    const auto side = pos.getSideToMove();
     const auto occupied = pos.getOccupiedSquares();
     const auto freeSquares = pos.getFreeSquares();
     const auto targetBitboard = ~pos.getPieces(side);
@@ -220,16 +271,16 @@ void MoveGen::generateLegalEvasions(const Position& pos, MoveList& moveList)
     // Pawn moves.
     auto tempPiece = pos.getBitboard(side, Piece::Pawn) & ~pinned;
     tempMove = (side ? tempPiece >> 8 : tempPiece << 8) & freeSquares;
-    addPawnSingleMovesFromMask(moveList, tempMove & interpose, true, side);
+    addPawnSingleMovesFromMask<side>(moveList, tempMove & interpose, true);
 
     tempMove = (side ? (tempMove & Bitboards::ranks[5]) >> 8 : (tempMove & Bitboards::ranks[2]) << 8) & freeSquares & interpose;
-    addPawnDoubleMovesFromMask(moveList, tempMove, side);
+    addPawnDoubleMovesFromMask<side>(moveList, tempMove);
 
     tempMove = (side ? tempPiece >> 9 : tempPiece << 7) & 0x7F7F7F7F7F7F7F7F & (checkers | ep);
-    addPawnCapturesFromMask<false>(moveList, tempMove, pos.getEnPassantSquare(), true, side);
+    addPawnCapturesFromMask<side, false>(moveList, tempMove, pos.getEnPassantSquare(), true);
 
     tempMove = (side ? tempPiece >> 7 : tempPiece << 9) & 0xFEFEFEFEFEFEFEFE & (checkers | ep);
-    addPawnCapturesFromMask<true>(moveList, tempMove, pos.getEnPassantSquare(), true, side);
+    addPawnCapturesFromMask<side, true>(moveList, tempMove, pos.getEnPassantSquare(), true);
 
     // Knight moves.
     tempPiece = pos.getBitboard(side, Piece::Knight) & ~pinned;
@@ -268,28 +319,38 @@ void MoveGen::generateLegalEvasions(const Position& pos, MoveList& moveList)
     }
 }
 
-void MoveGen::generatePseudoLegalQuietMoves(const Position& pos, MoveList& moveList)
+template <int8_t side, bool legal>
+void MoveGen::generateQuietMoves(const Position& pos, MoveSpan& moveList)
 {
-    const auto side = pos.getSideToMove();
+    assert(pos.getSideToMove() == side);
+    assert(!legal || !pos.inCheck());
     const auto freeSquares = pos.getFreeSquares();
     const auto occupiedSquares = pos.getOccupiedSquares();
+    const auto pinned = pos.getPinnedPieces();
+    const auto kingSquare = Bitboards::lsb(pos.getBitboard(side, Piece::King));
+    const auto firstPawnMove = moveList.size();
 
     // Pawn moves.
     auto tempPiece = pos.getBitboard(side, Piece::Pawn);
     auto tempMove = (side ? tempPiece >> 8 : tempPiece << 8) & freeSquares & 0x00FFFFFFFFFFFF00;
-    addPawnSingleMovesFromMask(moveList, tempMove, true, side);
+    addPawnSingleMovesFromMask<side>(moveList, tempMove, true);
 
     tempMove = (side ? (tempMove & Bitboards::ranks[5]) >> 8 : (tempMove & Bitboards::ranks[2]) << 8) & freeSquares;
-    addPawnDoubleMovesFromMask(moveList, tempMove, side);
+    addPawnDoubleMovesFromMask<side>(moveList, tempMove);
+
+    if (legal && (tempPiece & pinned))
+    {
+        removeIllegalPawnMoves(pos, moveList, firstPawnMove);
+    }
 
     // King moves. Castling is handled later for no reason.
-    auto from = Bitboards::lsb(pos.getBitboard(side, Piece::King));
+    auto from = kingSquare;
     tempMove = Bitboards::kingAttacks(from) & freeSquares;
-    addPieceMovesFromMask(moveList, tempMove, from);
+    addPieceMovesFromMask(moveList, legal ? safeKingTargets<side>(pos, tempMove) : tempMove, from);
 
     // Knight moves.
     // Since pinned knights do not have legal moves we can remove them.
-    tempPiece = pos.getBitboard(side, Piece::Knight) & ~pos.getPinnedPieces();
+    tempPiece = pos.getBitboard(side, Piece::Knight) & ~pinned;
     while (tempPiece)
     {
         from = Bitboards::popLsb(tempPiece);
@@ -302,7 +363,7 @@ void MoveGen::generatePseudoLegalQuietMoves(const Position& pos, MoveList& moveL
     while (tempPiece)
     {
         from = Bitboards::popLsb(tempPiece);
-        tempMove = Bitboards::bishopAttacks(from, occupiedSquares) & freeSquares;
+        tempMove = Bitboards::bishopAttacks(from, occupiedSquares) & freeSquares & (legal ? pinRay(pinned, kingSquare, from) : ~0ULL);
         addPieceMovesFromMask(moveList, tempMove, from);
     }
 
@@ -311,7 +372,7 @@ void MoveGen::generatePseudoLegalQuietMoves(const Position& pos, MoveList& moveL
     while (tempPiece)
     {
         from = Bitboards::popLsb(tempPiece);
-        tempMove = Bitboards::rookAttacks(from, occupiedSquares) & freeSquares;
+        tempMove = Bitboards::rookAttacks(from, occupiedSquares) & freeSquares & (legal ? pinRay(pinned, kingSquare, from) : ~0ULL);
         addPieceMovesFromMask(moveList, tempMove, from);
     }
 
@@ -320,7 +381,7 @@ void MoveGen::generatePseudoLegalQuietMoves(const Position& pos, MoveList& moveL
     while (tempPiece)
     {
         from = Bitboards::popLsb(tempPiece);
-        tempMove = Bitboards::queenAttacks(from, occupiedSquares) & freeSquares;
+        tempMove = Bitboards::queenAttacks(from, occupiedSquares) & freeSquares & (legal ? pinRay(pinned, kingSquare, from) : ~0ULL);
         addPieceMovesFromMask(moveList, tempMove, from);
     }
 
@@ -349,9 +410,11 @@ void MoveGen::generatePseudoLegalQuietMoves(const Position& pos, MoveList& moveL
     }
 }
 
-void MoveGen::generatePseudoLegalCapturesAndQuietChecks(const Position& pos, MoveList& moveList)
+template <int8_t side, bool legal>
+void MoveGen::generateCapturesAndQuietChecks(const Position& pos, MoveSpan& moveList)
 {
-    const auto side = pos.getSideToMove();
+    assert(pos.getSideToMove() == side);
+    assert(!legal || !pos.inCheck());
     const auto occupied = pos.getOccupiedSquares();
     const auto targetBitboard = ~pos.getPieces(side);
     const auto opponentPieces = pos.getPieces(!side);
@@ -360,36 +423,44 @@ void MoveGen::generatePseudoLegalCapturesAndQuietChecks(const Position& pos, Mov
     const auto rookCheckSquares = Bitboards::rookAttacks(opponentKingSquare, occupied);
     const auto dcCandidates = pos.getDiscoveredCheckCandidates();
     const auto ep = (pos.getEnPassantSquare() != Square::NoSquare ? Bitboards::bit(pos.getEnPassantSquare()) : 0);
+    const auto pinned = pos.getPinnedPieces();
+    const auto kingSquare = Bitboards::lsb(pos.getBitboard(side, Piece::King));
+    const auto firstPawnMove = moveList.size();
 
     // Pawn moves.
     auto tempPiece = pos.getBitboard(side, Piece::Pawn);
     auto tempMove = (side ? tempPiece >> 9 : tempPiece << 7) & 0x7F7F7F7F7F7F7F7F & (opponentPieces | ep);
-    addPawnCapturesFromMask<false>(moveList, tempMove, pos.getEnPassantSquare(), false, side);
+    addPawnCapturesFromMask<side, false>(moveList, tempMove, pos.getEnPassantSquare(), false);
     tempMove = (side ? tempPiece >> 7 : tempPiece << 9) & 0xFEFEFEFEFEFEFEFE & (opponentPieces | ep);
-    addPawnCapturesFromMask<true>(moveList, tempMove, pos.getEnPassantSquare(), false, side);
+    addPawnCapturesFromMask<side, true>(moveList, tempMove, pos.getEnPassantSquare(), false);
 
     // A pawn push discovered check can be generated by a pawn only when the pawn is not on the same file as the opposing king.
     const auto promotionDiscoveredMask = (dcCandidates & ~Bitboards::files[file(opponentKingSquare)])
                                        | (side ? Bitboards::ranks[1] : Bitboards::ranks[6]);
     tempMove = (side ? (tempPiece & promotionDiscoveredMask) >> 8 : (tempPiece & promotionDiscoveredMask) << 8) & ~occupied;
-    addPawnSingleMovesFromMask(moveList, tempMove, false, side);
+    addPawnSingleMovesFromMask<side>(moveList, tempMove, false);
     tempMove = (side ? (tempMove & Bitboards::ranks[5]) >> 8 : (tempMove & Bitboards::ranks[2]) << 8) & ~occupied;
-    addPawnDoubleMovesFromMask(moveList, tempMove, side);
+    addPawnDoubleMovesFromMask<side>(moveList, tempMove);
 
     tempMove = (side ? (tempPiece & ~promotionDiscoveredMask) >> 8 : (tempPiece & ~promotionDiscoveredMask) << 8) & ~occupied;
-    addPawnSingleMovesFromMask(moveList, tempMove & Bitboards::pawnAttacks(!side, opponentKingSquare), false, side);
+    addPawnSingleMovesFromMask<side>(moveList, tempMove & Bitboards::pawnAttacks(!side, opponentKingSquare), false);
     tempMove = (side ? (tempMove & Bitboards::ranks[5]) >> 8 : (tempMove & Bitboards::ranks[2]) << 8) & ~occupied;
-    addPawnDoubleMovesFromMask(moveList, tempMove & Bitboards::pawnAttacks(!side, opponentKingSquare), side);
+    addPawnDoubleMovesFromMask<side>(moveList, tempMove & Bitboards::pawnAttacks(!side, opponentKingSquare));
+
+    if (legal && ((pos.getBitboard(side, Piece::Pawn) & pinned) || ep))
+    {
+        removeIllegalPawnMoves(pos, moveList, firstPawnMove);
+    }
 
     // King moves without castling.
-    auto from = Bitboards::lsb(pos.getBitboard(side, Piece::King));
+    auto from = kingSquare;
     tempMove = Bitboards::kingAttacks(from)
              & (!Bitboards::testBit(dcCandidates, from) ? opponentPieces
                                                         : (targetBitboard & ~Bitboards::lineFormedBySquares(from, opponentKingSquare)));
-    addPieceMovesFromMask(moveList, tempMove, from);
+    addPieceMovesFromMask(moveList, legal ? safeKingTargets<side>(pos, tempMove) : tempMove, from);
 
     // Knight moves.
-    tempPiece = pos.getBitboard(side, Piece::Knight);
+    tempPiece = pos.getBitboard(side, Piece::Knight) & (legal ? ~pinned : ~0ULL);
     while (tempPiece)
     {
         from = Bitboards::popLsb(tempPiece);
@@ -406,7 +477,7 @@ void MoveGen::generatePseudoLegalCapturesAndQuietChecks(const Position& pos, Mov
     while (tempPiece)
     {
         from = Bitboards::popLsb(tempPiece);
-        tempMove = Bitboards::bishopAttacks(from, occupied) & targetBitboard;
+        tempMove = Bitboards::bishopAttacks(from, occupied) & targetBitboard & (legal ? pinRay(pinned, kingSquare, from) : ~0ULL);
         if (!Bitboards::testBit(dcCandidates, from))
         {
             tempMove &= opponentPieces | bishopCheckSquares;
@@ -419,7 +490,7 @@ void MoveGen::generatePseudoLegalCapturesAndQuietChecks(const Position& pos, Mov
     while (tempPiece)
     {
         from = Bitboards::popLsb(tempPiece);
-        tempMove = Bitboards::rookAttacks(from, occupied) & targetBitboard;
+        tempMove = Bitboards::rookAttacks(from, occupied) & targetBitboard & (legal ? pinRay(pinned, kingSquare, from) : ~0ULL);
         if (!Bitboards::testBit(dcCandidates, from))
         {
             tempMove &= opponentPieces | rookCheckSquares;
@@ -432,7 +503,7 @@ void MoveGen::generatePseudoLegalCapturesAndQuietChecks(const Position& pos, Mov
     while (tempPiece)
     {
         from = Bitboards::popLsb(tempPiece);
-        tempMove = Bitboards::queenAttacks(from, occupied) & targetBitboard;
+        tempMove = Bitboards::queenAttacks(from, occupied) & targetBitboard & (legal ? pinRay(pinned, kingSquare, from) : ~0ULL);
         if (!Bitboards::testBit(dcCandidates, from))
         {
             tempMove &= opponentPieces | bishopCheckSquares | rookCheckSquares;
@@ -441,31 +512,41 @@ void MoveGen::generatePseudoLegalCapturesAndQuietChecks(const Position& pos, Mov
     }
 }
 
-void MoveGen::generatePseudoLegalCaptures(const Position& pos, MoveList& moveList, bool underPromotions)
+template <int8_t side, bool legal>
+void MoveGen::generateCaptures(const Position& pos, MoveSpan& moveList, bool underPromotions)
 {
-    const auto side = pos.getSideToMove();
+    assert(pos.getSideToMove() == side);
+    assert(!legal || !pos.inCheck());
     const auto enemyPieces = pos.getPieces(!side);
     const auto occupiedSquares = pos.getOccupiedSquares();
     const auto ep = (pos.getEnPassantSquare() != Square::NoSquare ? Bitboards::bit(pos.getEnPassantSquare()) : 0);
+    const auto pinned = pos.getPinnedPieces();
+    const auto kingSquare = Bitboards::lsb(pos.getBitboard(side, Piece::King));
+    const auto firstPawnMove = moveList.size();
 
     // Pawn moves.
     auto tempPiece = pos.getBitboard(side, Piece::Pawn);
     auto tempMove = (side ? (tempPiece & Bitboards::ranks[1]) >> 8 : (tempPiece & Bitboards::ranks[6]) << 8) & pos.getFreeSquares();
-    addPawnSingleMovesFromMask(moveList, tempMove, underPromotions, side);
+    addPawnSingleMovesFromMask<side>(moveList, tempMove, underPromotions);
 
     tempMove = (side ? tempPiece >> 9 : tempPiece << 7) & 0x7F7F7F7F7F7F7F7F & (enemyPieces | ep);
-    addPawnCapturesFromMask<false>(moveList, tempMove, pos.getEnPassantSquare(), underPromotions, side);
+    addPawnCapturesFromMask<side, false>(moveList, tempMove, pos.getEnPassantSquare(), underPromotions);
 
     tempMove = (side ? tempPiece >> 7 : tempPiece << 9) & 0xFEFEFEFEFEFEFEFE & (enemyPieces | ep);
-    addPawnCapturesFromMask<true>(moveList, tempMove, pos.getEnPassantSquare(), underPromotions, side);
+    addPawnCapturesFromMask<side, true>(moveList, tempMove, pos.getEnPassantSquare(), underPromotions);
+
+    if (legal && ((tempPiece & pinned) || ep))
+    {
+        removeIllegalPawnMoves(pos, moveList, firstPawnMove);
+    }
 
     // King moves.
-    auto from = Bitboards::lsb(pos.getBitboard(side, Piece::King));
+    auto from = kingSquare;
     tempMove = Bitboards::kingAttacks(from) & enemyPieces;
-    addPieceMovesFromMask(moveList, tempMove, from);
+    addPieceMovesFromMask(moveList, legal ? safeKingTargets<side>(pos, tempMove) : tempMove, from);
 
     // Knight moves.
-    tempPiece = pos.getBitboard(side, Piece::Knight);
+    tempPiece = pos.getBitboard(side, Piece::Knight) & (legal ? ~pinned : ~0ULL);
     while (tempPiece)
     {
         from = Bitboards::popLsb(tempPiece);
@@ -478,7 +559,7 @@ void MoveGen::generatePseudoLegalCaptures(const Position& pos, MoveList& moveLis
     while (tempPiece)
     {
         from = Bitboards::popLsb(tempPiece);
-        tempMove = Bitboards::bishopAttacks(from, occupiedSquares) & enemyPieces;
+        tempMove = Bitboards::bishopAttacks(from, occupiedSquares) & enemyPieces & (legal ? pinRay(pinned, kingSquare, from) : ~0ULL);
         addPieceMovesFromMask(moveList, tempMove, from);
     }
 
@@ -487,7 +568,7 @@ void MoveGen::generatePseudoLegalCaptures(const Position& pos, MoveList& moveLis
     while (tempPiece)
     {
         from = Bitboards::popLsb(tempPiece);
-        tempMove = Bitboards::rookAttacks(from, occupiedSquares) & enemyPieces;
+        tempMove = Bitboards::rookAttacks(from, occupiedSquares) & enemyPieces & (legal ? pinRay(pinned, kingSquare, from) : ~0ULL);
         addPieceMovesFromMask(moveList, tempMove, from);
     }
 
@@ -496,8 +577,59 @@ void MoveGen::generatePseudoLegalCaptures(const Position& pos, MoveList& moveLis
     while (tempPiece)
     {
         from = Bitboards::popLsb(tempPiece);
-        tempMove = Bitboards::queenAttacks(from, occupiedSquares) & enemyPieces;
+        tempMove = Bitboards::queenAttacks(from, occupiedSquares) & enemyPieces & (legal ? pinRay(pinned, kingSquare, from) : ~0ULL);
         addPieceMovesFromMask(moveList, tempMove, from);
     }
 }
 
+void MoveGen::generatePseudoLegalMoves(const Position& pos, MoveSpan& moveList)
+{
+    pos.getSideToMove() ? generateMoves<Color::Black, false>(pos, moveList) : generateMoves<Color::White, false>(pos, moveList);
+}
+
+void MoveGen::generateLegalEvasions(const Position& pos, MoveSpan& moveList)
+{
+    pos.getSideToMove() ? generateLegalEvasions<Color::Black>(pos, moveList) : generateLegalEvasions<Color::White>(pos, moveList);
+}
+
+void MoveGen::generatePseudoLegalQuietMoves(const Position& pos, MoveSpan& moveList)
+{
+    pos.getSideToMove() ? generateQuietMoves<Color::Black, false>(pos, moveList) : generateQuietMoves<Color::White, false>(pos, moveList);
+}
+
+void MoveGen::generatePseudoLegalCapturesAndQuietChecks(const Position& pos, MoveSpan& moveList)
+{
+    pos.getSideToMove() ? generateCapturesAndQuietChecks<Color::Black, false>(pos, moveList) : generateCapturesAndQuietChecks<Color::White, false>(pos, moveList);
+}
+
+void MoveGen::generatePseudoLegalCaptures(const Position& pos, MoveSpan& moveList, bool underPromotions)
+{
+    pos.getSideToMove() ? generateCaptures<Color::Black, false>(pos, moveList, underPromotions) : generateCaptures<Color::White, false>(pos, moveList, underPromotions);
+}
+
+void MoveGen::generateLegalMoves(const Position& pos, MoveSpan& moveList)
+{
+    if (pos.inCheck())
+    {
+        generateLegalEvasions(pos, moveList);
+    }
+    else
+    {
+        pos.getSideToMove() ? generateMoves<Color::Black, true>(pos, moveList) : generateMoves<Color::White, true>(pos, moveList);
+    }
+}
+
+void MoveGen::generateLegalQuietMoves(const Position& pos, MoveSpan& moveList)
+{
+    pos.getSideToMove() ? generateQuietMoves<Color::Black, true>(pos, moveList) : generateQuietMoves<Color::White, true>(pos, moveList);
+}
+
+void MoveGen::generateLegalCapturesAndQuietChecks(const Position& pos, MoveSpan& moveList)
+{
+    pos.getSideToMove() ? generateCapturesAndQuietChecks<Color::Black, true>(pos, moveList) : generateCapturesAndQuietChecks<Color::White, true>(pos, moveList);
+}
+
+void MoveGen::generateLegalCaptures(const Position& pos, MoveSpan& moveList, bool underPromotions)
+{
+    pos.getSideToMove() ? generateCaptures<Color::Black, true>(pos, moveList, underPromotions) : generateCaptures<Color::White, true>(pos, moveList, underPromotions);
+}
@@ -35,22 +35,22 @@ public:
     /// @brief Generates pseudo-legal moves.
     /// @param pos The position for which to generate moves.
     /// @param moveList The movelist into which we should put the generated moves.
-    static void generatePseudoLegalMoves(const Position& pos, MoveList& moveList);
+    static void generatePseudoLegalMoves(const Position& pos, MoveSpan& moveList);
 
     /// @brief Generates legal evasion moves. Should NOT be called if not in check.
     /// @param pos The position for which to generate moves.
     /// @param moveList The movelist into which we should put the generated moves.
-    static void generateLegalEvasions(const Position& pos, MoveList& moveList);
+    static void generateLegalEvasions(const Position& pos, MoveSpan& moveList);
 
     /// @brief Generates pseudo-legal quiet (i.e. non-capture) moves.
     /// @param pos The position for which to generate moves.
     /// @param moveList The movelist into which we should put the generated moves.
-    static void generatePseudoLegalQuietMoves(const Position& pos, MoveList& moveList);
+    static void generatePseudoLegalQuietMoves(const Position& pos, MoveSpan& moveList);
 
     /// @brief Generates pseudo-legal capture moves, promotions and quiet checks.
     /// @param pos The position for which to generate moves.
     /// @param moveList The movelist into which we should put the generated moves.
-    static void generatePseudoLegalCapturesAndQuietChecks(const Position& pos, MoveList& moveList);
+    static void generatePseudoLegalCapturesAndQuietChecks(const Position& pos, MoveSpan& moveList);
 
     /// @brief Generates pseudo-legal capture moves and promotions.
     /// @param pos The position for which to generate moves.
@@ -59,7 +59,46 @@ public:
     ///
     /// In the quiescence search generating underpromotions is a waste of time.
     /// On the other hand, in the main search NOT generating underpromotions could potentially have disastrous effects.
-    static void generatePseudoLegalCaptures(const Position& pos, MoveList& moveList, bool underPromotions);
+    static void generatePseudoLegalCaptures(const Position& pos, MoveSpan& moveList, bool underPromotions);
+
+    /// @brief Generates legal moves. Uses generateLegalEvasions when in check.
+    /// @param pos The position for which to generate moves.
+    /// @param moveList The movelist into which we should put the generated moves.
+    static void generateLegalMoves(const Position& pos, MoveSpan& moveList);
+
+    /// @brief Generates the legal moves out of the ones generated by generatePseudoLegalQuietMoves. Should NOT be called if in check.
+    /// @param pos The position for which to generate moves.
+    /// @param moveList The movelist into which we should put the generated moves.
+    static void generateLegalQuietMoves(const Position& pos, MoveSpan& moveList);
+
+    /// @brief Generates the legal moves out of the ones generated by generatePseudoLegalCapturesAndQuietChecks. Should NOT be called if in check.
+    /// @param pos The position for which to generate moves.
+    /// @param moveList The movelist into which we should put the generated moves.
+    static void generateLegalCapturesAndQuietChecks(const Position& pos, MoveSpan& moveList);
+
+    /// @brief Generates the legal moves out of the ones generated by generatePseudoLegalCaptures. Should NOT be called if in check.
+    /// @param pos The position for which to generate moves.
+    /// @param moveList The movelist into which we should put the generated moves.
+    /// @param underPromotions Whether we should generate underpromotions or not.
+    static void generateLegalCaptures(const Position& pos, MoveSpan& moveList, bool underPromotions);
+
+private:
+    // The actual move generation functions are templated on the side to move so that pawn directions, promotion ranks and castling squares are known at compile time.
+    // They are also templated on whether to generate only legal moves. Pinned pieces are then limited to the line through the king and the king to squares which are not attacked.
+    template <int8_t side, bool legal>
+    static void generateMoves(const Position& pos, MoveSpan& moveList);
+
+    template <int8_t side>
+    static void generateLegalEvasions(const Position& pos, MoveSpan& moveList);
+
+    template <int8_t side, bool legal>
+    static void generateQuietMoves(const Position& pos, MoveSpan& moveList);
+
+    template <int8_t side, bool legal>
+    static void generateCapturesAndQuietChecks(const Position& pos, MoveSpan& moveList);
+
+    template <int8_t side, bool legal>
+    static void generateCaptures(const Position& pos, MoveSpan& moveList, bool underPromotions);
 };
 
 #endif
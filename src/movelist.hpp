@@ -22,20 +22,31 @@
 #define MOVELIST_HPP_
 
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
 #include <array>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE4_1__)
+#include <smmintrin.h>
+#endif
 #include "move.hpp"
 
-/// @brief Holds generated moves and their move ordering scores.
+/// @brief A list of generated moves and their move ordering scores stored in a buffer owned by someone else.
 ///
-/// Maximum amount of moves supported is 256.
-/// We don't initialize the array containing moves due to it being too expensive. 
+/// The buffer must have room for all moves added, at most 256 moves are generated at once.
+/// We don't initialize the buffer containing moves due to it being too expensive. 
 /// Due to this, extra care must be taken not to use uninitialized values.
 /// Some static code analyzers complain about that but it is working as intended.
-class MoveList
+class MoveSpan
 {
 public:
-    /// @brief Default constructor.
-    MoveList() noexcept;
+    /// @brief Constructs an empty list at the start of a buffer.
+    /// @param buffer The buffer.
+    explicit MoveSpan(uint32_t* buffer) noexcept;
+
+    MoveSpan(const MoveSpan&) = delete;
+    MoveSpan& operator=(const MoveSpan&) = delete;
 
     /// @brief Get the move at a given index.
     /// @param index The index.
@@ -57,10 +68,18 @@ public:
     /// @param newScore The new score.
     void setScore(int index, int16_t newScore);
 
-    /// @brief Assignment operator which is faster than the default one generated by the compiler.
-    /// @param rhs The right-hand side of the assignent.
-    /// @return A reference to the lhs movelist.
-    MoveList& operator=(const MoveList& rhs);
+    /// @brief Swaps two moves together with their scores.
+    /// @param a The index of the first move.
+    /// @param b The index of the second move.
+    void swap(int a, int b);
+
+    /// @brief Finds the move with the highest score in a part of the movelist.
+    /// @param first The index of the first move to look at.
+    /// @param last One past the index of the last move to look at. Must be larger than first.
+    /// @return The index of the move with the highest score. If several moves have the highest score, the first one of them.
+    ///
+    /// This is the inner loop of the selection sort used for ordering moves, so it uses AVX2 or SSE4.1 when we are compiled for them.
+    int bestIndex(int first, int last) const;
 
     /// @brief A perfect forwarder for adding new moves to the movelist.
     template<class... T>
@@ -81,28 +100,52 @@ public:
     /// @return True if the movelist is empty, false otherwise.
     bool empty() const noexcept;
 
-private:
-    std::array<uint32_t, 256> mMoveBuffer;
-    int32_t mNumberOfMoves;
+protected:
+    uint32_t* mMoveBuffer;
+    // Not int32_t, the compiler would have to assume that every move written to the buffer can change it.
+    std::ptrdiff_t mNumberOfMoves;
 };
 
-inline MoveList::MoveList() noexcept : mNumberOfMoves(0) 
+/// @brief A movelist with a buffer of its own.
+///
+/// Maximum amount of moves supported is 256.
+/// The buffer takes a kilobyte, so the search uses the StackMoveLists of a MoveStack instead.
+class MoveList : public MoveSpan
 {
+public:
+    /// @brief Default constructor.
+    MoveList() noexcept;
+
+    /// @brief Copy constructor, copies only the moves in use.
+    /// @param rhs The movelist to copy.
+    MoveList(const MoveList& rhs) noexcept;
+
+    /// @brief Assignment operator which is faster than the default one generated by the compiler.
+    /// @param rhs The right-hand side of the assignent.
+    /// @return A reference to the lhs movelist.
+    MoveList& operator=(const MoveList& rhs);
+
+private:
+    std::array<uint32_t, 256> mStorage;
 };
 
-inline Move MoveList::getMove(int index) const
+inline MoveSpan::MoveSpan(uint32_t* buffer) noexcept : mMoveBuffer(buffer), mNumberOfMoves(0)
+{
+}
+
+inline Move MoveSpan::getMove(int index) const
 {
     assert(index >= 0 && index < mNumberOfMoves);
     return static_cast<uint16_t>(mMoveBuffer[index]);
 }
 
-inline int16_t MoveList::getScore(int index) const
+inline int16_t MoveSpan::getScore(int index) const
 {
     assert(index >= 0 && index < mNumberOfMoves);
     return static_cast<int16_t>(mMoveBuffer[index] >> 16);
 }
 
-inline void MoveList::setMove(int index, const Move& newMove)
+inline void MoveSpan::setMove(int index, const Move& newMove)
 {
     assert(index >= 0 && index < mNumberOfMoves);
     mMoveBuffer[index] &= 0xFFFF0000;
@@ -110,7 +153,7 @@ inline void MoveList::setMove(int index, const Move& newMove)
     assert(getMove(index) == newMove);
 }
 
-inline void MoveList::setScore(int index, int16_t newScore)
+inline void MoveSpan::setScore(int index, int16_t newScore)
 {
     assert(index >= 0 && index < mNumberOfMoves);
     mMoveBuffer[index] &= 0xFFFF;
@@ -118,40 +161,131 @@ inline void MoveList::setScore(int index, int16_t newScore)
     assert(getScore(index) == newScore);
 }
 
-inline MoveList& MoveList::operator=(const MoveList& rhs)
+inline void MoveSpan::swap(int a, int b)
 {
-    mNumberOfMoves = rhs.mNumberOfMoves;
-    for (auto i = 0; i < rhs.size(); ++i)
+    assert(a >= 0 && a < mNumberOfMoves);
+    assert(b >= 0 && b < mNumberOfMoves);
+    const auto tmp = mMoveBuffer[a];
+    mMoveBuffer[a] = mMoveBuffer[b];
+    mMoveBuffer[b] = tmp;
+}
+
+inline int MoveSpan::bestIndex(int first, int last) const
+{
+    assert(first >= 0 && first < last && last <= mNumberOfMoves);
+#if defined(__AVX2__) || defined(__SSE4_1__)
+    // The score is in the upper half, so comparing the entries as signed integers compares the scores.
+    // Replacing the move with 0xFFFF minus the index makes every key unique and the first of the equal scores the largest,
+    // so a branchless maximum of the keys gives the index as well.
+    const auto entries = mMoveBuffer + first;
+    const auto n = last - first;
+    auto i = 0;
+    auto bestKey = INT32_MIN;
+ #if defined(__AVX2__)
+    if (n >= 8)
     {
-        mMoveBuffer[i] = rhs.mMoveBuffer[i];
+        const auto scoreMask = _mm256_set1_epi32(static_cast<int32_t>(0xFFFF0000));
+        const auto step = _mm256_set1_epi32(8);
+        auto indices = _mm256_setr_epi32(0xFFFF, 0xFFFE, 0xFFFD, 0xFFFC, 0xFFFB, 0xFFFA, 0xFFF9, 0xFFF8);
+        auto keys = _mm256_set1_epi32(INT32_MIN);
+        for (; i + 8 <= n; i += 8)
+        {
+            const auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(entries + i));
+            keys = _mm256_max_epi32(keys, _mm256_or_si256(_mm256_and_si256(v, scoreMask), indices));
+            indices = _mm256_sub_epi32(indices, step);
+        }
+        auto key = _mm_max_epi32(_mm256_castsi256_si128(keys), _mm256_extracti128_si256(keys, 1));
+        key = _mm_max_epi32(key, _mm_shuffle_epi32(key, _MM_SHUFFLE(1, 0, 3, 2)));
+        key = _mm_max_epi32(key, _mm_shuffle_epi32(key, _MM_SHUFFLE(2, 3, 0, 1)));
+        bestKey = _mm_cvtsi128_si32(key);
     }
-    return *this;
+ #else
+    if (n >= 4)
+    {
+        const auto scoreMask = _mm_set1_epi32(static_cast<int32_t>(0xFFFF0000));
+        const auto step = _mm_set1_epi32(4);
+        auto indices = _mm_setr_epi32(0xFFFF, 0xFFFE, 0xFFFD, 0xFFFC);
+        auto key = _mm_set1_epi32(INT32_MIN);
+        for (; i + 4 <= n; i += 4)
+        {
+            const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(entries + i));
+            key = _mm_max_epi32(key, _mm_or_si128(_mm_and_si128(v, scoreMask), indices));
+            indices = _mm_sub_epi32(indices, step);
+        }
+        key = _mm_max_epi32(key, _mm_shuffle_epi32(key, _MM_SHUFFLE(1, 0, 3, 2)));
+        key = _mm_max_epi32(key, _mm_shuffle_epi32(key, _MM_SHUFFLE(2, 3, 0, 1)));
+        bestKey = _mm_cvtsi128_si32(key);
+    }
+ #endif
+    for (; i < n; ++i)
+    {
+        const auto key = static_cast<int32_t>((entries[i] & 0xFFFF0000) | static_cast<uint32_t>(0xFFFF - i));
+        bestKey = (key > bestKey ? key : bestKey);
+    }
+
+    return first + 0xFFFF - (bestKey & 0xFFFF);
+#else
+    // Without SIMD the keys don't pay off, a plain scan with a branch is faster.
+    auto best = first;
+    auto bestScore = getScore(first);
+    for (auto i = first + 1; i < last; ++i)
+    {
+        if (getScore(i) > bestScore)
+        {
+            bestScore = getScore(i);
+            best = i;
+        }
+    }
+
+    return best;
+#endif
 }
 
 template<class... T>
-inline void MoveList::emplace_back(T&&... args)
+inline void MoveSpan::emplace_back(T&&... args)
 {
     mMoveBuffer[mNumberOfMoves++] = Move(std::forward<T>(args)...).getRawMove();
 }
 
-inline void MoveList::clear() noexcept
+inline void MoveSpan::clear() noexcept
 { 
     mNumberOfMoves = 0;
 };
 
-inline void MoveList::resize(int newSize) noexcept
+inline void MoveSpan::resize(int newSize) noexcept
 { 
     mNumberOfMoves = newSize;
 }
 
-inline int MoveList::size() const noexcept
+inline int MoveSpan::size() const noexcept
 { 
     return mNumberOfMoves;
 }
 
-inline bool MoveList::empty() const noexcept
+inline bool MoveSpan::empty() const noexcept
 { 
     return !mNumberOfMoves;
 }
 
+inline MoveList::MoveList() noexcept : MoveSpan(nullptr)
+{
+    mMoveBuffer = mStorage.data();
+}
+
+inline MoveList::MoveList(const MoveList& rhs) noexcept : MoveSpan(nullptr)
+{
+    mMoveBuffer = mStorage.data();
+    *this = rhs;
+}
+
+inline MoveList& MoveList::operator=(const MoveList& rhs)
+{
+    mNumberOfMoves = rhs.mNumberOfMoves;
+    for (auto i = 0; i < rhs.size(); ++i)
+    {
+        mMoveBuffer[i] = rhs.mMoveBuffer[i];
+    }
+    return *this;
+}
+
 #endif
@@ -26,30 +26,29 @@ enum Phase {
     Stop
 };
 
-MoveSort::MoveSort(const Position& pos, const HistoryTable& historyTable, Move ttMove, Move k1, Move k2, Move counter, bool inCheck) :
-mPos(pos), mHistoryTable(historyTable), mTtMove(ttMove), mKiller1(k1), mKiller2(k2), mCounter(counter)
+MoveSort::MoveSort(const Position& pos, const HistoryTable& historyTable, Move ttMove, Move k1, Move k2, Move counter, bool inCheck, MoveStack& moveStack) :
+mPos(pos), mHistoryTable(historyTable), mMoveList(moveStack), mTtMove(ttMove), mKiller1(k1), mKiller2(k2), mCounter(counter)
 {
     mPhase = inCheck ? Evasion : Normal;
     mCurrentLocation = 0;
-    if (pos.pseudoLegal(ttMove, inCheck))
-    {
-        mMoveList.resize(1);
-    }
+    mPhaseEnd = pos.pseudoLegal(ttMove, inCheck) && pos.legal(ttMove, inCheck) ? 1 : 0;
+    mBadCaptures = mCapturesEnd = 0;
 }
 
 void MoveSort::generateNextPhase()
 {
     ++mPhase;
-    mCurrentLocation = 0;
-    mMoveList.clear();
+    // Each phase adds its moves to the end of the list, the earlier ones are not needed anymore except for the bad captures.
+    mCurrentLocation = mMoveList.size();
 
     if (mPhase == GoodCaptures)
     {
-        MoveGen::generatePseudoLegalCaptures(mPos, mMoveList, true);
-        for (auto i = 0; i < mMoveList.size(); ++i)
+        MoveGen::generateLegalCaptures(mPos, mMoveList, true);
+        for (auto i = mCurrentLocation; i < mMoveList.size(); ++i)
         {
             mMoveList.setScore(i, mPos.SEE(mMoveList.getMove(i)));
         }
+        mBadCaptures = mCapturesEnd = mMoveList.size();
     }
     else if (mPhase == Killers)
     {
@@ -62,33 +61,37 @@ void MoveSort::generateNextPhase()
     }
     else if (mPhase == QuietMoves)
     {
-        MoveGen::generatePseudoLegalQuietMoves(mPos, mMoveList);
-        for (auto i = 0; i < mMoveList.size(); ++i)
+        MoveGen::generateLegalQuietMoves(mPos, mMoveList);
+        for (auto i = mCurrentLocation; i < mMoveList.size(); ++i)
         {
             mMoveList.setScore(i, mHistoryTable.getScore(mPos, mMoveList.getMove(i)));
         }
     }
     else if (mPhase == BadCaptures)
     {
-        mMoveList = mTemp;
+        mCurrentLocation = mBadCaptures;
+        mPhaseEnd = mCapturesEnd;
+        return;
     }
     else if (mPhase == Evasions)
     {
         MoveGen::generateLegalEvasions(mPos, mMoveList);
-        if (mMoveList.size() > 1) scoreEvasions();
+        if (mMoveList.size() - mCurrentLocation > 1) scoreEvasions();
     }
     else if (mPhase == Normal || mPhase == Evasion || mPhase == Stop)
     {
         mPhase = Stop;
-        mMoveList.resize(mCurrentLocation + 1);
+        mPhaseEnd = mCurrentLocation + 1;
+        return;
     }
+    mPhaseEnd = mMoveList.size();
 }
 
 Move MoveSort::next()
 {
     for (;;)
     {
-        while (mCurrentLocation == mMoveList.size())
+        while (mCurrentLocation == mPhaseEnd)
         {
             generateNextPhase();
         }
@@ -101,22 +104,22 @@ Move MoveSort::next()
         else if (mPhase == GoodCaptures)
         {
             selectionSort(mCurrentLocation);
-            const auto move = mMoveList.getMove(mCurrentLocation);
-            const auto score = mMoveList.getScore(mCurrentLocation++);
+            if (mMoveList.getScore(mCurrentLocation) < 0)
+            {
+                // The captures are sorted, so the rest of them are bad captures. Leave them where they are and come back to them after the quiet moves.
+                mBadCaptures = mPhaseEnd = mCurrentLocation;
+                continue;
+            }
+            const auto move = mMoveList.getMove(mCurrentLocation++);
             if (move != mTtMove)
             {
-                if (score >= 0)
-                {
-                    return move;
-                }
-                // Put bad captures into a temporary movelist.
-                mTemp.emplace_back(move);
+                return move;
             }
         }
         else if (mPhase == Killers)
         {
             const auto move = mMoveList.getMove(mCurrentLocation++);
-            if (!move.empty() && move != mTtMove && !mPos.captureOrPromotion(move) && mPos.pseudoLegal(move, false))
+            if (!move.empty() && move != mTtMove && !mPos.captureOrPromotion(move) && mPos.pseudoLegal(move, false) && mPos.legal(move, false))
             {
                 return move;
             }
@@ -133,8 +136,12 @@ Move MoveSort::next()
         }
         else if (mPhase == BadCaptures)
         {
-            // We already sorted the bad captures above and checked that they do not equal the TT-move.
-            return mMoveList.getMove(mCurrentLocation++);
+            selectionSort(mCurrentLocation);
+            const auto move = mMoveList.getMove(mCurrentLocation++);
+            if (move != mTtMove)
+            {
+                return move;
+            }
         }
         else if (mPhase == Evasions)
         {
@@ -158,7 +165,7 @@ void MoveSort::scoreEvasions()
     static const int16_t hashMoveScore = 30000;
     static const int16_t captureMoveScore = hashMoveScore >> 1;
 
-    for (auto i = 0; i < mMoveList.size(); ++i)
+    for (auto i = mCurrentLocation; i < mMoveList.size(); ++i)
     {
         const auto move = mMoveList.getMove(i);
 
@@ -180,28 +187,7 @@ void MoveSort::scoreEvasions()
 
 void MoveSort::selectionSort(int startingLocation)
 {
-    auto bestLocation = startingLocation;
-    auto bestScore = mMoveList.getScore(startingLocation);
-
-    for (auto i = startingLocation + 1; i < mMoveList.size(); ++i)
-    {
-        if (mMoveList.getScore(i) > bestScore)
-        {
-            bestScore = mMoveList.getScore(i);
-            bestLocation = i;
-        }
-    }
-
-    if (bestLocation > startingLocation)
-    {
-        // Swap the values at bestLocation and startingLocation.
-        const auto m = mMoveList.getMove(startingLocation);
-        const auto s = mMoveList.getScore(startingLocation);
-        mMoveList.setMove(startingLocation, mMoveList.getMove(bestLocation));
-        mMoveList.setScore(startingLocation, mMoveList.getScore(bestLocation));
-        mMoveList.setMove(bestLocation, m);
-        mMoveList.setScore(bestLocation, s);
-    }
+    mMoveList.swap(startingLocation, mMoveList.bestIndex(startingLocation, mPhaseEnd));
 }
 
 
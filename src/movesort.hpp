@@ -21,7 +21,7 @@
 #ifndef MOVESORT_HPP_
 #define MOVESORT_HPP_
 
-#include "movelist.hpp"
+#include "movestack.hpp"
 #include "position.hpp"
 #include "history.hpp"
 
@@ -39,19 +39,24 @@ public:
     /// @param k2 The second killer move.
     /// @param counter The counter move.
     /// @param inCheck Whether the position is in check or not.
-    MoveSort(const Position& pos, const HistoryTable& history, Move ttMove, Move k1, Move k2, Move counter, bool inCheck);
+    /// @param moveStack The move stack of the searching thread, the moves of all phases are kept in a single list on top of it.
+    MoveSort(const Position& pos, const HistoryTable& history, Move ttMove, Move k1, Move k2, Move counter, bool inCheck, MoveStack& moveStack);
 
     /// @brief Generates the next best (according to heuristics) move.
-    /// @return A move. If there are no more moves, the move is empty.
+    /// @return A legal move. If there are no more moves, the move is empty.
     Move next();
 
 private:
     const Position& mPos;
     const HistoryTable& mHistoryTable;
-    MoveList mMoveList, mTemp;
+    StackMoveList mMoveList;
     Move mTtMove, mKiller1, mKiller2, mCounter;
     int mPhase;
     int mCurrentLocation;
+    // The moves of the current phase end here. The bad captures stay in place after the good ones, from mBadCaptures to mCapturesEnd.
+    int mPhaseEnd;
+    int mBadCaptures;
+    int mCapturesEnd;
 
     void generateNextPhase();
     void scoreEvasions();
@@ -0,0 +1,88 @@
+/*
+    Hakkapeliitta - A UCI chess engine. Copyright (C) 2013-2015 Mikko Aarnos.
+
+    Hakkapeliitta is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Hakkapeliitta is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Hakkapeliitta. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/// @file movestack.hpp
+/// @author Mikko Aarnos
+
+#ifndef MOVESTACK_HPP_
+#define MOVESTACK_HPP_
+
+#include <cassert>
+#include <vector>
+#include "movelist.hpp"
+#include "constants.hpp"
+
+class StackMoveList;
+
+/// @brief A contiguous buffer for the movelists of the search, one per searching thread.
+///
+/// Every ply takes a StackMoveList from the top of the stack and gives it back when it returns, so the lists of consecutive plies are next to each other in memory.
+/// Unlike with a MoveList per ply, a ply takes only as much space as it has generated moves and the deeper plies reuse the same cache lines over and over again.
+class MoveStack
+{
+public:
+    /// @brief Default constructor. Allocates enough space for the maximum search depth.
+    MoveStack();
+
+private:
+    // A ply keeps the moves of all phases of the move ordering, which are always less than two full movelists.
+    static const int maxMovesPerPly = 512;
+
+    std::vector<uint32_t> mBuffer;
+    StackMoveList* mTop;
+
+    friend class StackMoveList;
+};
+
+/// @brief A movelist taken from the top of a MoveStack.
+///
+/// The lists must be destroyed in the reverse order of construction, which happens automatically when they are local variables.
+/// Moves can only be added to the topmost list, adding moves to a list below it would overwrite the moves of the lists above.
+class StackMoveList : public MoveSpan
+{
+public:
+    /// @brief Takes a new list from the top of a stack.
+    /// @param stack The stack.
+    explicit StackMoveList(MoveStack& stack);
+
+    /// @brief Destructor, gives the space back to the stack.
+    ~StackMoveList();
+
+private:
+    MoveStack& mStack;
+    StackMoveList* mPrevious;
+};
+
+inline MoveStack::MoveStack() :
+    mBuffer((maxPly + 1) * maxMovesPerPly), mTop(nullptr)
+{
+}
+
+inline StackMoveList::StackMoveList(MoveStack& stack) :
+    MoveSpan(stack.mTop ? stack.mTop->mMoveBuffer + stack.mTop->mNumberOfMoves : stack.mBuffer.data()), mStack(stack), mPrevious(stack.mTop)
+{
+    assert(mMoveBuffer + MoveStack::maxMovesPerPly <= stack.mBuffer.data() + stack.mBuffer.size());
+    stack.mTop = this;
+}
+
+inline StackMoveList::~StackMoveList()
+{
+    assert(mStack.mTop == this);
+    mStack.mTop = mPrevious;
+}
+
+#endif
@@ -0,0 +1,69 @@
+/*
+    Hakkapeliitta - A UCI chess engine. Copyright (C) 2013-2015 Mikko Aarnos.
+
+    Hakkapeliitta is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Hakkapeliitta is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Hakkapeliitta. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "packed_position.hpp"
+#include "bitboards.hpp"
+
+PackedPosition::PackedPosition(const Position& pos, int16_t score) noexcept :
+    mOccupied(pos.getOccupiedSquares()), mPieces({}), mScore(score), mGamePly(static_cast<uint16_t>(pos.getGamePly())),
+    mSideToMoveAndCastlingRights(static_cast<uint8_t>(pos.getSideToMove() | (pos.getCastlingRights() << 1))),
+    mEnPassant(static_cast<uint8_t>(pos.getEnPassantSquare())), mFiftyMoveDistance(pos.getFiftyMoveDistance()), mResult(Draw)
+{
+    auto occupied = mOccupied;
+    for (auto i = 0; occupied; ++i)
+    {
+        const auto sq = Bitboards::popLsb(occupied);
+        mPieces[i / 2] |= static_cast<uint8_t>(pos.getBoard(sq) << (4 * (i % 2)));
+    }
+}
+
+Position PackedPosition::getPosition() const
+{
+    std::array<Piece, 64> board;
+    board.fill(Piece::Empty);
+    auto occupied = mOccupied;
+    for (auto i = 0; occupied; ++i)
+    {
+        board[Bitboards::popLsb(occupied)] = static_cast<int8_t>((mPieces[i / 2] >> (4 * (i % 2))) & 15);
+    }
+
+    return Position(board, mSideToMoveAndCastlingRights & 1, static_cast<uint8_t>(mSideToMoveAndCastlingRights >> 1), 
+                    mEnPassant, mFiftyMoveDistance, static_cast<int16_t>(mGamePly));
+}
+
+PackedPositionReader::PackedPositionReader(const std::string& fileName) :
+    mFile(fileName, std::ios::binary), mBufferPosition(0)
+{
+}
+
+bool PackedPositionReader::read(PackedPosition& packedPosition)
+{
+    if (mBufferPosition == mBuffer.size())
+    {
+        mBuffer.resize(4096);
+        mFile.read(reinterpret_cast<char*>(mBuffer.data()), mBuffer.size() * sizeof(PackedPosition));
+        mBuffer.resize(static_cast<size_t>(mFile.gcount()) / sizeof(PackedPosition));
+        mBufferPosition = 0;
+        if (mBuffer.empty())
+        {
+            return false;
+        }
+    }
+
+    packedPosition = mBuffer[mBufferPosition++];
+    return true;
+}
@@ -0,0 +1,132 @@
+/*
+    Hakkapeliitta - A UCI chess engine. Copyright (C) 2013-2015 Mikko Aarnos.
+
+    Hakkapeliitta is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Hakkapeliitta is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Hakkapeliitta. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/// @file packed_position.hpp
+/// @author Mikko Aarnos
+
+#ifndef PACKED_POSITION_HPP_
+#define PACKED_POSITION_HPP_
+
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "position.hpp"
+
+/// @brief A position packed into 32 bytes together with a search score and the result of the game it was played in.
+///
+/// Used for storing the large amounts of labelled positions needed for tuning the evaluation function.
+/// The occupied squares are stored as a bitboard and the pieces on them as 4-bit values in the order of the squares.
+/// Since there can't be more than 32 pieces on the board 16 bytes are enough for the pieces.
+/// The score and the result are both from the point of view of the side to move.
+class PackedPosition
+{
+public:
+    /// @brief The possible results of a game, from the point of view of the side to move.
+    enum Result : int8_t
+    {
+        Loss = -1, Draw = 0, Win = 1
+    };
+
+    /// @brief Default constructor.
+    PackedPosition() noexcept;
+
+    /// @brief Packs a given position.
+    /// @param pos The position.
+    /// @param score The score of the position given by the search.
+    PackedPosition(const Position& pos, int16_t score) noexcept;
+
+    /// @brief Unpacks the position.
+    /// @return The position.
+    Position getPosition() const;
+
+    /// @brief Get the score of the position.
+    /// @return The score.
+    int16_t getScore() const noexcept;
+
+    /// @brief Get the result of the game the position was played in.
+    /// @return The result.
+    int8_t getResult() const noexcept;
+
+    /// @brief Sets the result of the game the position was played in.
+    /// @param result The result.
+    void setResult(int8_t result) noexcept;
+
+private:
+    uint64_t mOccupied;
+    std::array<uint8_t, 16> mPieces;
+    int16_t mScore;
+    uint16_t mGamePly;
+    uint8_t mSideToMoveAndCastlingRights;
+    uint8_t mEnPassant;
+    uint8_t mFiftyMoveDistance;
+    int8_t mResult;
+};
+
+static_assert(sizeof(PackedPosition) == 32, "PackedPosition must be 32 bytes");
+
+/// @brief Used for reading a file of packed positions in large blocks.
+class PackedPositionReader
+{
+public:
+    /// @brief Opens a given file for reading.
+    /// @param fileName The name of the file.
+    PackedPositionReader(const std::string& fileName);
+
+    /// @brief Checks if the file was opened succesfully.
+    /// @return True if the file is open.
+    bool isOpen() const;
+
+    /// @brief Reads the next packed position from the file.
+    /// @param packedPosition The position read.
+    /// @return False if there are no positions left, true otherwise.
+    bool read(PackedPosition& packedPosition);
+
+private:
+    std::ifstream mFile;
+    std::vector<PackedPosition> mBuffer;
+    size_t mBufferPosition;
+};
+
+inline PackedPosition::PackedPosition() noexcept :
+    mOccupied(0), mPieces({}), mScore(0), mGamePly(0), mSideToMoveAndCastlingRights(0),
+    mEnPassant(Square::NoSquare), mFiftyMoveDistance(0), mResult(Draw)
+{
+}
+
+inline int16_t PackedPosition::getScore() const noexcept
+{
+    return mScore;
+}
+
+inline int8_t PackedPosition::getResult() const noexcept
+{
+    return mResult;
+}
+
+inline void PackedPosition::setResult(int8_t result) noexcept
+{
+    mResult = result;
+}
+
+inline bool PackedPositionReader::isOpen() const
+{
+    return mFile.is_open();
+}
+
+#endif
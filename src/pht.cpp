@@ -18,9 +18,13 @@
 #include "pht.hpp"
 #include "bitboards.hpp"
 #include <cassert>
+#include <algorithm>
 #include <cmath>
+#include <memory>
+#include <utility>
 
-PawnHashTable::PawnHashTable()
+PawnHashTable::PawnHashTable() :
+    mTable(nullptr), mTableSize(0)
 {
     setSize(4); 
 }
@@ -33,40 +37,62 @@ void PawnHashTable::setSize(size_t sizeInMegaBytes)
         sizeInMegaBytes = static_cast<size_t>(std::pow(2, std::floor(log2(sizeInMegaBytes))));
     }
 
-    const auto tableSize = ((sizeInMegaBytes * 1024 * 1024) / sizeof(PawnHashTableEntry));
-    mTable.clear();
-    mTable.resize(tableSize);
-    mTable.shrink_to_fit();
+    const auto tableSize = ((sizeInMegaBytes * 1024 * 1024) / sizeof(Bucket));
+
+    // Free the old table first, two big tables might not fit in memory at the same time.
+    mMemory.reset();
+    mMemory.reset(new char[tableSize * sizeof(Bucket) + sizeof(Bucket) - 1]);
+
+    // Otherwise every bucket would straddle two cachelines and a probe could take two cache misses.
+    const auto address = reinterpret_cast<uintptr_t>(mMemory.get());
+    mTable = reinterpret_cast<Bucket*>((address + sizeof(Bucket) - 1) & ~static_cast<uintptr_t>(sizeof(Bucket) - 1));
+    mTableSize = tableSize;
+    std::uninitialized_fill_n(mTable, mTableSize, Bucket());
 }
 
 void PawnHashTable::clear()
 {
-    const auto tableSize = mTable.size();
-    mTable.clear();
-    mTable.resize(tableSize);
+    std::fill(mTable, mTable + mTableSize, Bucket());
 }
 
-void PawnHashTable::save(HashKey phk, int scoreOp, int scoreEd)
+const PawnHashTable::PawnHashTableEntry* PawnHashTable::save(HashKey phk, const PawnHashTableEntry& entry)
 {
-    auto& hashEntry = mTable[phk & (mTable.size() - 1)];
+    auto& bucket = mTable[phk & (mTableSize - 1)];
 
-    hashEntry.setData((scoreOp & 0xffff) | (scoreEd << 16));
-    hashEntry.setHash(phk ^ hashEntry.getData());
+    // The new entry is the most recently used one, so push the old first entry to the second place. 
+    // The old second entry is the least recently used one so it gets overwritten.
+    bucket[1] = bucket[0];
+    bucket[0] = entry;
+    bucket[0].setHash(phk);
+
+    return &bucket[0];
+}
 
-    assert(hashEntry.getScoreOp() == scoreOp);
-    assert(hashEntry.getScoreEd() == scoreEd);
+void PawnHashTable::prefetch(HashKey phk) const
+{
+    const auto* address = reinterpret_cast<const char*>(&mTable[phk & (mTableSize - 1)]);
+#if defined (_MSC_VER) || defined(__INTEL_COMPILER)
+    _mm_prefetch(address, _MM_HINT_T0);
+#else
+    __builtin_prefetch(address);
+#endif
 }
 
-bool PawnHashTable::probe(HashKey phk, int& scoreOp, int& scoreEd) const
+const PawnHashTable::PawnHashTableEntry* PawnHashTable::probe(HashKey phk)
 {
-    const auto& hashEntry = mTable[phk & (mTable.size() - 1)];
+    auto& bucket = mTable[phk & (mTableSize - 1)];
+
+    if (bucket[0].getHash() == phk)
+    {
+        return &bucket[0];
+    }
 
-    if ((hashEntry.getHash() ^ hashEntry.getData()) == phk)
+    if (bucket[1].getHash() == phk)
     {
-        scoreOp = hashEntry.getScoreOp();
-        scoreEd = hashEntry.getScoreEd();
-        return true;
+        // Move the entry to the front, it is now the most recently used one.
+        std::swap(bucket[0], bucket[1]);
+        return &bucket[0];
     }
 
-    return false;
+    return nullptr;
 }
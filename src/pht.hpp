@@ -22,15 +22,77 @@
 #define PHT_HPP_
 
 #include <cstdint>
-#include <vector>
+#include <cassert>
+#include <array>
+#include <memory>
 #include "zobrist.hpp"
+#include "color.hpp"
 
 /// @brief Hash table for speeding up pawn evaluation.
 ///
 /// Default size of the pawn hash table is 4MB.
+/// Besides the pawn structure score the entries contain other information which only depends on the pawns, so that the evaluation function doesn't have to recalculate it.
 class PawnHashTable
 {
 public:
+    /// @brief A single entry in the pawn hash table.
+    class PawnHashTableEntry
+    {
+    public:
+        /// @brief Default constructor.
+        PawnHashTableEntry() noexcept;
+
+        /// @brief Get the pawn hash key of this entry.
+        /// @return The pawn hash key.
+        HashKey getHash() const noexcept;
+
+        /// @brief Set the pawn hash key of this entry.
+        /// @param newHash The new pawn hash key.
+        void setHash(HashKey newHash) noexcept;
+
+        /// @brief Get the opening pawn structure score.
+        /// @return The score.
+        int16_t getScoreOp() const noexcept;
+
+        /// @brief Get the ending pawn structure score.
+        /// @return The score.
+        int16_t getScoreEd() const noexcept;
+
+        /// @brief Set the pawn structure scores.
+        /// @param scoreOp The opening score.
+        /// @param scoreEd The ending score.
+        void setScores(int scoreOp, int scoreEd) noexcept;
+
+        /// @brief Checks if a given color has no pawns on a given file.
+        /// @param c The color.
+        /// @param f The file.
+        /// @return True if there are no pawns of the given color on the file, false otherwise.
+        bool isSemiOpenFile(Color c, int f) const;
+
+        /// @brief Set the files which have no pawns of a given color.
+        /// @param c The color.
+        /// @param files A byte which has bit i set if the color has no pawns on file i.
+        void setSemiOpenFiles(Color c, uint8_t files);
+
+        /// @brief Get the pawn shelter penalty of a given color with the king on a given file.
+        /// @param c The color.
+        /// @param kingFile The file of the king.
+        /// @return The penalty.
+        int getKingShelter(Color c, int kingFile) const;
+
+        /// @brief Set the pawn shelter penalty of a given color with the king on a given file.
+        /// @param c The color.
+        /// @param kingFile The file of the king.
+        /// @param penalty The penalty.
+        void setKingShelter(Color c, int kingFile, int penalty);
+
+    private:
+        HashKey mHash;
+        int16_t mScoreOp, mScoreEd;
+        std::array<uint8_t, 2> mSemiOpenFiles;
+        std::array<std::array<uint8_t, 8>, 2> mKingShelter;
+    };
+
     /// @brief Default constructor.
     PawnHashTable();
 
@@ -41,64 +103,85 @@ public:
     /// @brief Clears the pawn hash table. Can potentially be an expensive operation.
     void clear();
 
-    /// @brief Save some information to the pawn hash table.
-    /// @param phk The pawn hash key of the position the information is for.
-    /// @param scoreOp The opening pawn score of the position.
-    /// @param scoreEd The ending pawn score of the position.
-    void save(HashKey phk, int scoreOp, int scoreEd);
+    /// @brief Save an entry to the pawn hash table. 
+    /// @param phk The pawn hash key of the position the entry is for.
+    /// @param entry The entry. The hash key of the entry is set by this function.
+    /// @return A valid pointer to the saved entry. The entry pointed to stays the same until the next call to save or probe.
+    const PawnHashTableEntry* save(HashKey phk, const PawnHashTableEntry& entry);
 
-    /// @brief Get some information from the hash table. 
+    /// @brief Get the pawn hash table entry for a given pawn hash key. 
     /// @param phk The pawn hash key of the position we are probing information for.
-    /// @param scoreOp On a succesful probe the opening pawn score is put here.
-    /// @param scoreEd On a succesful probe the ending pawn score is put here.
-    /// @return True on a succesful probe, false otherwise.
-    bool probe(HashKey phk, int& scoreOp, int& scoreEd) const;
+    /// @return A valid pointer to the entry if the probe is succesful, a nullptr otherwise. The entry pointed to stays the same until the next call to save or probe.
+    ///
+    /// Not const since a succesful probe marks the entry as recently used, which is used in the replacement policy.
+    const PawnHashTableEntry* probe(HashKey phk);
+
+    /// @brief Load the bucket of a given pawn hash key into the cache. Used as a speed optimization.
+    /// @param phk The pawn hash key.
+    void prefetch(HashKey phk) const;
 
 private:
-    // A single entry in the pawn hash table.
-    class PawnHashTableEntry
-    {
-    public:
-        PawnHashTableEntry() noexcept : mHash(0), mData(0) 
-        {
-        }
-
-        void setHash(uint64_t newHash) noexcept 
-        {
-            mHash = newHash; 
-        }
-
-        void setData(uint64_t newData) noexcept 
-        { 
-            mData = newData; 
-        }
-
-        uint64_t getHash() const noexcept 
-        { 
-            return mHash; 
-        }
-
-        uint64_t getData() const noexcept 
-        { 
-            return mData; 
-        }
-
-        int16_t getScoreOp() const noexcept 
-        {
-            return static_cast<int16_t>(mData);
-        }
-
-        int16_t getScoreEd() const noexcept
-        { 
-            return static_cast<int16_t>(mData >> 16); 
-        }
+    // Each bucket contains two entries. The most recently used entry is always the first one, and a new entry always replaces the second one.
+    // That way the entries which age out of the table are the ones which haven't been needed for the longest time.
+    typedef std::array<PawnHashTableEntry, 2> Bucket;
+    static_assert(sizeof(Bucket) == 64, "A bucket must fill a cacheline exactly.");
+
+    Bucket* mTable;
+    size_t mTableSize;
+    // The memory of the table. It is a bit larger than the table, new only guarantees the alignment of the largest built-in type.
+    std::unique_ptr<char[]> mMemory;
+};
 
-    private:
-        uint64_t mHash;
-        uint64_t mData;
-    };
+inline PawnHashTable::PawnHashTableEntry::PawnHashTableEntry() noexcept : 
+    mHash(~0ULL), mScoreOp(0), mScoreEd(0), mSemiOpenFiles({ { 0, 0 } }), mKingShelter({})
+{
+}
 
-    std::vector<PawnHashTableEntry> mTable;
-};
+inline HashKey PawnHashTable::PawnHashTableEntry::getHash() const noexcept
+{
+    return mHash;
+}
+
+inline void PawnHashTable::PawnHashTableEntry::setHash(HashKey newHash) noexcept
+{
+    mHash = newHash;
+}
+
+inline int16_t PawnHashTable::PawnHashTableEntry::getScoreOp() const noexcept
+{
+    return mScoreOp;
+}
+
+inline int16_t PawnHashTable::PawnHashTableEntry::getScoreEd() const noexcept
+{
+    return mScoreEd;
+}
+
+inline void PawnHashTable::PawnHashTableEntry::setScores(int scoreOp, int scoreEd) noexcept
+{
+    mScoreOp = static_cast<int16_t>(scoreOp);
+    mScoreEd = static_cast<int16_t>(scoreEd);
+}
+
+inline bool PawnHashTable::PawnHashTableEntry::isSemiOpenFile(Color c, int f) const
+{
+    return (mSemiOpenFiles[c] & (1 << f)) != 0;
+}
+
+inline void PawnHashTable::PawnHashTableEntry::setSemiOpenFiles(Color c, uint8_t files)
+{
+    mSemiOpenFiles[c] = files;
+}
+
+inline int PawnHashTable::PawnHashTableEntry::getKingShelter(Color c, int kingFile) const
+{
+    return mKingShelter[c][kingFile];
+}
+
+inline void PawnHashTable::PawnHashTableEntry::setKingShelter(Color c, int kingFile, int penalty)
+{
+    assert(penalty >= 0 && penalty <= 255);
+    mKingShelter[c][kingFile] = static_cast<uint8_t>(penalty);
+}
 
 #endif
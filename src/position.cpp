@@ -168,6 +168,19 @@ Position::Position(const std::string& fen)
         }
     }
 
+    initialize();
+}
+
+Position::Position(const std::array<Piece, 64>& board, Color sideToMove, uint8_t castlingRights, 
+                   Square enPassant, uint8_t fiftyMoveDistance, int16_t gamePly) :
+    mBoard(board), mSideToMove(sideToMove), mCastlingRights(castlingRights), mEnPassant(enPassant), 
+    mFiftyMoveDistance(fiftyMoveDistance), mGamePly(gamePly)
+{
+    initialize();
+}
+
+void Position::initialize()
+{
     // Populate the bitboards.
     mBitboards.fill(0);
     mPieceCounts.fill(0);
@@ -369,6 +382,86 @@ void Position::makeNullMove()
     mDcCandidates = discoveredCheckCandidates();
 }
 
+HashKey Position::hashKeyAfter(const Move& m) const
+{
+    const auto side = mSideToMove;
+    const auto from = m.getFrom();
+    const auto to = m.getTo();
+    const auto flags = m.getFlags();
+    const auto piece = mBoard[from];
+    const auto captured = mBoard[to];
+    auto hk = mHashKey ^ Zobrist::turnHashKey() ^ Zobrist::pieceHashKey(piece, from) ^ Zobrist::pieceHashKey(piece, to);
+
+    if (mEnPassant != Square::NoSquare)
+    {
+        hk ^= Zobrist::enPassantHashKey(mEnPassant);
+    }
+
+    if (captured != Piece::Empty)
+    {
+        hk ^= Zobrist::pieceHashKey(captured, to);
+    }
+
+    if (piece.getPieceType() == Piece::Pawn)
+    {
+        if ((to ^ from) == 16) // Double pawn move
+        {
+            hk ^= Zobrist::enPassantHashKey(from ^ 24);
+        }
+        else if (flags == Piece::Pawn) // En passant
+        {
+            hk ^= Zobrist::pieceHashKey(Piece::Pawn + !side * 6, to ^ 8);
+        }
+        else if (flags != Piece::Empty) // Promotion
+        {
+            hk ^= Zobrist::pieceHashKey(Piece::Pawn + side * 6, to) ^ Zobrist::pieceHashKey(flags + side * 6, to);
+        }
+    }
+    else if (flags == Piece::King)
+    {
+        const auto fromRook = (from > to ? (to - 2) : (to + 1));
+        const auto toRook = (from + to) / 2;
+        hk ^= Zobrist::pieceHashKey(Piece::Rook + side * 6, fromRook) ^ Zobrist::pieceHashKey(Piece::Rook + side * 6, toRook);
+    }
+
+    if (mCastlingRights && (castlingMask[from] | castlingMask[to]))
+    {
+        hk ^= Zobrist::castlingRightsHashKey(mCastlingRights & (castlingMask[from] | castlingMask[to]));
+    }
+
+    return hk;
+}
+
+HashKey Position::pawnHashKeyAfter(const Move& m) const
+{
+    const auto from = m.getFrom();
+    const auto to = m.getTo();
+    const auto flags = m.getFlags();
+    const auto piece = mBoard[from];
+    const auto captured = mBoard[to];
+    auto phk = mPawnHashKey;
+
+    if (captured != Piece::Empty && captured.getPieceType() == Piece::Pawn)
+    {
+        phk ^= Zobrist::pieceHashKey(captured, to);
+    }
+
+    if (piece.getPieceType() == Piece::Pawn)
+    {
+        phk ^= Zobrist::pieceHashKey(piece, from) ^ Zobrist::pieceHashKey(piece, to);
+        if (flags == Piece::Pawn) // En passant
+        {
+            phk ^= Zobrist::pieceHashKey(Piece::Pawn + !mSideToMove * 6, to ^ 8);
+        }
+        else if (flags != Piece::Empty) // Promotion
+        {
+            phk ^= Zobrist::pieceHashKey(piece, to);
+        }
+    }
+
+    return phk;
+}
+
 template <bool side>
 bool Position::isAttacked(Square sq, Bitboard occupied) const
 {
@@ -629,14 +722,36 @@ int Position::givesCheck(const Move& move) const
     return 0;
 }
 
-int16_t Position::SEE(const Move& move) const
+// Approximate piece values, SEE doesn't need to be as accurate as the main evaluation function.
+// Score for kings is not mateScore due to some annoying wrap-around problems. Doesn't really matter though.
+const std::array<int16_t, 13> seePieceValues = {
+    100, 300, 300, 500, 900, 10000, 100, 300, 300, 500, 900, 10000, 0
+};
+
+Bitboard Position::attackersTo(Square sq, Bitboard occupied) const
 {
-    // Approximate piece values, SEE doesn't need to be as accurate as the main evaluation function.
-    // Score for kings is not mateScore due to some annoying wrap-around problems. Doesn't really matter though.
-    static const std::array<int16_t, 13> pieceValues = {
-        100, 300, 300, 500, 900, 10000, 100, 300, 300, 500, 900, 10000, 0
-    };
+    return (Bitboards::rookAttacks(sq, occupied) & getRooksAndQueens())
+         | (Bitboards::bishopAttacks(sq, occupied) & getBishopsAndQueens())
+         | (Bitboards::knightAttacks(sq) & (mBitboards[Piece::WhiteKnight] | mBitboards[Piece::BlackKnight]))
+         | (Bitboards::kingAttacks(sq) & (mBitboards[Piece::WhiteKing] | mBitboards[Piece::BlackKing]))
+         | (Bitboards::pawnAttacks(Color::Black, sq) & (mBitboards[Piece::WhitePawn]))
+         | (Bitboards::pawnAttacks(Color::White, sq) & (mBitboards[Piece::BlackPawn]));
+}
 
+Square Position::leastValuableAttacker(Bitboard attackers, Color side) const
+{
+    for (Piece p = Piece::Pawn; p < Piece::King; ++p)
+    {
+        if (getBitboard(side, p) & attackers)
+        {
+            return Bitboards::lsb(getBitboard(side, p) & attackers);
+        }
+    }
+    return Bitboards::lsb(getBitboard(side, Piece::King));
+}
+
+int16_t Position::SEE(const Move& move) const
+{
     std::array<int16_t, 32> materialGains;
     auto occupied = getOccupiedSquares();
     const auto from = move.getFrom();
@@ -645,7 +760,6 @@ int16_t Position::SEE(const Move& move) const
     const auto toAtPromoRank = (to <= 7 || to >= 56);
     auto stm = mSideToMove;
     int16_t lastAttackerValue;
-    int next;
 
     if (flags == Piece::King)
     {
@@ -653,68 +767,39 @@ int16_t Position::SEE(const Move& move) const
     }
     else if (flags == Piece::Pawn)
     {
-        materialGains[0] = pieceValues[Piece::Pawn];
-        lastAttackerValue = pieceValues[Piece::Pawn];
+        materialGains[0] = seePieceValues[Piece::Pawn];
+        lastAttackerValue = seePieceValues[Piece::Pawn];
         Bitboards::clearBit(occupied, mEnPassant ^ 8);
     }
     else
     {
-        materialGains[0] = pieceValues[mBoard[to]];
-        lastAttackerValue = pieceValues[mBoard[from]];
+        materialGains[0] = seePieceValues[mBoard[to]];
+        lastAttackerValue = seePieceValues[mBoard[from]];
         if (flags != Piece::Empty)
         {
-            materialGains[0] += pieceValues[flags] - pieceValues[Piece::Pawn];
-            lastAttackerValue += pieceValues[flags] - pieceValues[Piece::Pawn];
+            materialGains[0] += seePieceValues[flags] - seePieceValues[Piece::Pawn];
+            lastAttackerValue += seePieceValues[flags] - seePieceValues[Piece::Pawn];
         }
     }
 
     Bitboards::clearBit(occupied, from);
-    auto attackers = (Bitboards::rookAttacks(to, occupied) & getRooksAndQueens())
-                   | (Bitboards::bishopAttacks(to, occupied) & getBishopsAndQueens())
-                   | (Bitboards::knightAttacks(to) & (mBitboards[Piece::WhiteKnight] | mBitboards[Piece::BlackKnight]))
-                   | (Bitboards::kingAttacks(to) & (mBitboards[Piece::WhiteKing] | mBitboards[Piece::BlackKing]))
-                   | (Bitboards::pawnAttacks(Color::Black, to) & (mBitboards[Piece::WhitePawn]))
-                   | (Bitboards::pawnAttacks(Color::White, to) & (mBitboards[Piece::BlackPawn]));
-    attackers &= occupied;
+    auto attackers = attackersTo(to, occupied) & occupied;
     stm = !stm;
     auto numberOfCaptures = 1;
 
     while (attackers & mBitboards[12 + stm])
     {
-        if (getBitboard(stm, Piece::Pawn) & attackers)
-        {
-            next = Bitboards::lsb(getBitboard(stm, Piece::Pawn) & attackers);
-        }
-        else if (getBitboard(stm, Piece::Knight) & attackers)
-        {
-            next = Bitboards::lsb(getBitboard(stm, Piece::Knight) & attackers);
-        }
-        else if (getBitboard(stm, Piece::Bishop) & attackers)
-        {
-            next = Bitboards::lsb(mBitboards[Piece::Bishop + stm * 6] & attackers);
-        }
-        else if (getBitboard(stm, Piece::Rook) & attackers)
-        {
-            next = Bitboards::lsb(getBitboard(stm, Piece::Rook) & attackers);
-        }
-        else if (getBitboard(stm, Piece::Queen) & attackers)
-        {
-            next = Bitboards::lsb(getBitboard(stm, Piece::Queen) & attackers);
-        }
-        else
-        {
-            next = Bitboards::lsb(getBitboard(stm, Piece::King));
-        }
+        const auto next = leastValuableAttacker(attackers, stm);
 
         // Update the materialgains array.
         materialGains[numberOfCaptures] = -materialGains[numberOfCaptures - 1] + lastAttackerValue;
         // Remember the value of the capturing piece because it is going to be captured next.
-        lastAttackerValue = pieceValues[mBoard[next]];
+        lastAttackerValue = seePieceValues[mBoard[next]];
         // If we are going to do a promotion we need to correct the values a bit.
-        if (toAtPromoRank && lastAttackerValue == pieceValues[Piece::Pawn])
+        if (toAtPromoRank && lastAttackerValue == seePieceValues[Piece::Pawn])
         {
-            materialGains[numberOfCaptures] += pieceValues[Piece::Queen] - pieceValues[Piece::Pawn];
-            lastAttackerValue += pieceValues[Piece::Queen] - pieceValues[Piece::Pawn];
+            materialGains[numberOfCaptures] += seePieceValues[Piece::Queen] - seePieceValues[Piece::Pawn];
+            lastAttackerValue += seePieceValues[Piece::Queen] - seePieceValues[Piece::Pawn];
         }
 
         Bitboards::clearBit(occupied, next);
@@ -739,6 +824,88 @@ int16_t Position::SEE(const Move& move) const
     return materialGains[0];
 }
 
+bool Position::seeGe(const Move& move, int threshold) const
+{
+    auto occupied = getOccupiedSquares();
+    const auto from = move.getFrom();
+    const auto to = move.getTo();
+    const auto flags = move.getFlags();
+    const auto toAtPromoRank = (to <= 7 || to >= 56);
+    // The material balance after the exchange so far from our point of view.
+    int balance, lastAttackerValue;
+
+    if (flags == Piece::King)
+    {
+        return threshold <= 0;
+    }
+    else if (flags == Piece::Pawn)
+    {
+        balance = seePieceValues[Piece::Pawn];
+        lastAttackerValue = seePieceValues[Piece::Pawn];
+        Bitboards::clearBit(occupied, mEnPassant ^ 8);
+    }
+    else
+    {
+        balance = seePieceValues[mBoard[to]];
+        lastAttackerValue = seePieceValues[mBoard[from]];
+        if (flags != Piece::Empty)
+        {
+            balance += seePieceValues[flags] - seePieceValues[Piece::Pawn];
+            lastAttackerValue += seePieceValues[flags] - seePieceValues[Piece::Pawn];
+        }
+    }
+
+    // The opponent can always decline to recapture.
+    if (balance < threshold)
+    {
+        return false;
+    }
+    // Losing the moved piece for nothing is still enough, unless the recapture promotes.
+    if (!toAtPromoRank && balance - lastAttackerValue >= threshold)
+    {
+        return true;
+    }
+
+    Bitboards::clearBit(occupied, from);
+    auto attackers = attackersTo(to, occupied) & occupied;
+    auto stm = !mSideToMove;
+
+    while (attackers & mBitboards[12 + stm])
+    {
+        const auto next = leastValuableAttacker(attackers, stm);
+
+        auto gain = lastAttackerValue;
+        lastAttackerValue = seePieceValues[mBoard[next]];
+        if (toAtPromoRank && lastAttackerValue == seePieceValues[Piece::Pawn])
+        {
+            gain += seePieceValues[Piece::Queen] - seePieceValues[Piece::Pawn];
+            lastAttackerValue += seePieceValues[Piece::Queen] - seePieceValues[Piece::Pawn];
+        }
+
+        Bitboards::clearBit(occupied, next);
+        attackers |= (Bitboards::rookAttacks(to, occupied) & getRooksAndQueens())
+                   | (Bitboards::bishopAttacks(to, occupied) & getBishopsAndQueens());
+        attackers &= occupied;
+
+        // The king cannot capture into an attacked square.
+        if (mBoard[next].getPieceType() == Piece::King && (attackers & mBitboards[12 + !stm]))
+        {
+            break;
+        }
+
+        balance += (stm == mSideToMove ? gain : -gain);
+        // The other side can stop the exchange here. If that is good enough for it, the outcome is decided.
+        if ((stm == mSideToMove) != (balance >= threshold))
+        {
+            return balance >= threshold;
+        }
+        stm = !stm;
+    }
+
+    // The side to move cannot capture anymore, and stopping was not good enough for it, otherwise we would have returned already.
+    return stm != mSideToMove;
+}
+
 int16_t Position::mvvLva(const Move& move) const
 {
     static const std::array<int16_t, 12> attackers = {
@@ -37,6 +37,16 @@ public:
     /// @param fen The FEN string.
     Position(const std::string& fen); 
 
+    /// @brief Constructs a Position from its parts. A lot faster than going through a FEN string.
+    /// @param board The pieces on each square.
+    /// @param sideToMove The side to move.
+    /// @param castlingRights The castling rights.
+    /// @param enPassant The en passant square, if any.
+    /// @param fiftyMoveDistance The amount of plies since the last capture or pawn move.
+    /// @param gamePly The ply of the game.
+    Position(const std::array<Piece, 64>& board, Color sideToMove, uint8_t castlingRights, 
+             Square enPassant, uint8_t fiftyMoveDistance, int16_t gamePly);
+
     /// @brief Get the piece on a given square.
     /// @param sq The square.
     /// @return The piece. Can be empty as well.
@@ -153,6 +163,16 @@ public:
     /// @brief Makes a null move. Unmake is unnecessary due to copy-make.
     void makeNullMove();
 
+    /// @brief Calculates the hash key of the position after a move without making the move. Used for prefetching the TT entry of the next position early.
+    /// @param move The move, must be pseudo-legal.
+    /// @return The hash key after the move.
+    HashKey hashKeyAfter(const Move& move) const;
+
+    /// @brief Calculates the pawn hash key of the position after a move without making the move.
+    /// @param move The move, must be pseudo-legal.
+    /// @return The pawn hash key after the move.
+    HashKey pawnHashKeyAfter(const Move& move) const;
+
     /// @brief Checks if the current side to move is in check.
     /// @return True if the side to mvoe is in check, false otherwise.
     bool inCheck() const;
@@ -192,6 +212,14 @@ public:
     /// @return The SEE score. The higher the better.
     int16_t SEE(const Move& move) const;
 
+    /// @brief Checks if the SEE score of a given move is at least a given threshold.
+    /// @param move The move.
+    /// @param threshold The threshold.
+    /// @return True if SEE(move) >= threshold.
+    ///
+    /// Faster than calculating the SEE score, as we can stop the exchange as soon as one side cannot do any worse or better than the threshold.
+    bool seeGe(const Move& move, int threshold) const;
+
     /// @brief Calculates the MVV-LVA score of a given move in the current position.
     /// @param move The move.
     /// @return The MVV-LVA score. The higher the better.
@@ -233,6 +261,13 @@ private:
     Bitboard pinnedPieces(Color c) const;
     Bitboard checkBlockers(Color c, Color kingColor) const;
 
+    // Used by SEE and seeGe. The x-ray attackers behind the pieces removed from occupied are not included.
+    Bitboard attackersTo(Square sq, Bitboard occupied) const;
+    Square leastValuableAttacker(Bitboard attackers, Color side) const;
+
+    // Calculates everything else from the board, side to move, castling rights and en passant square.
+    void initialize();
+
     // These functions can be used to calculate different hash keys for the current position.
     // They are slow so they are only used when initializing, instead we update them incrementally.
     HashKey calculateHash() const;
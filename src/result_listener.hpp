@@ -0,0 +1,140 @@
+/*
+    Hakkapeliitta - A UCI chess engine. Copyright (C) 2013-2015 Mikko Aarnos.
+
+    Hakkapeliitta is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Hakkapeliitta is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Hakkapeliitta. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/// @file result_listener.hpp
+/// @author Mikko Aarnos
+
+#ifndef RESULT_LISTENER_HPP_
+#define RESULT_LISTENER_HPP_
+
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+#include "search_listener.hpp"
+
+/// @brief A SearchListener which collects the results of a search instead of printing them.
+///
+/// Used when the engine runs searches on its own, for example when analysing a file of positions or playing games against itself.
+class ResultListener : public SearchListener
+{
+public:
+    /// @brief Default constructor.
+    ResultListener();
+
+    /// @brief Clears the results of the previous search. Must be called before starting a new search.
+    void reset();
+
+    /// @brief Blocks until the search in progress has sent its best move.
+    void waitForBestMove();
+
+    /// @brief The point of the search where a new best move appeared.
+    struct BestMoveChange
+    {
+        Move mMove;
+        uint64_t mSearchTime;
+        uint64_t mNodeCount;
+        int mDepth;
+    };
+
+    /// @brief The final principal variation.
+    std::vector<Move> mPv;
+
+    /// @brief Every change of the best move in the order they happened.
+    std::vector<BestMoveChange> mBestMoveChanges;
+
+    /// @brief The amount of nodes searched.
+    uint64_t mNodeCount;
+
+    /// @brief The depth of the last PV sent.
+    int mDepth;
+
+    /// @brief The score of the last PV sent.
+    int mScore;
+
+private:
+    virtual void infoCurrMove(const Move& move, int depth, int i);
+    virtual void infoRegular(uint64_t nodeCount, uint64_t tbHits, uint64_t searchTime, int hashFull);
+    virtual void infoPv(const std::vector<Move>& pv, uint64_t searchTime,
+                        uint64_t nodeCount, uint64_t tbHits,
+                        int depth, int score, int flags, int selDepth, int hashFull, int multiPv);
+    virtual void infoBestMove(const std::vector<Move>& pv, uint64_t searchTime,
+                              uint64_t nodeCount, uint64_t tbHits);
+
+    bool mFinished;
+    std::mutex mMutex;
+    std::condition_variable mCv;
+};
+
+inline ResultListener::ResultListener() :
+    mNodeCount(0), mDepth(0), mScore(0), mFinished(false)
+{
+}
+
+inline void ResultListener::reset()
+{
+    mPv.clear();
+    mBestMoveChanges.clear();
+    mNodeCount = 0;
+    mDepth = 0;
+    mScore = 0;
+}
+
+inline void ResultListener::waitForBestMove()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    while (!mFinished)
+    {
+        mCv.wait(lock);
+    }
+    mFinished = false;
+}
+
+inline void ResultListener::infoCurrMove(const Move&, int, int)
+{
+}
+
+inline void ResultListener::infoRegular(uint64_t, uint64_t, uint64_t, int)
+{
+}
+
+inline void ResultListener::infoPv(const std::vector<Move>& pv, uint64_t searchTime, uint64_t nodeCount, uint64_t,
+                                   int depth, int score, int, int, int, int multiPv)
+{
+    // Only the main line is of interest.
+    if (multiPv > 1)
+    {
+        return;
+    }
+
+    mDepth = depth;
+    mScore = score;
+    if (!pv.empty() && (mBestMoveChanges.empty() || mBestMoveChanges.back().mMove != pv[0]))
+    {
+        mBestMoveChanges.push_back({ pv[0], searchTime, nodeCount, depth });
+    }
+}
+
+inline void ResultListener::infoBestMove(const std::vector<Move>& pv, uint64_t, uint64_t nodeCount, uint64_t)
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    mPv = pv;
+    mNodeCount = nodeCount;
+    mFinished = true;
+    mCv.notify_one();
+}
+
+#endif
@@ -16,6 +16,8 @@
 */
 
 #include "search.hpp"
+#include <algorithm>
+#include <fstream>
 #include "movegen.hpp"
 #include "movesort.hpp"
 #include "utils/clamp.hpp"
@@ -54,7 +56,7 @@ int realScoreToTtScore(int score, int ply)
 
 // Used for ordering moves during the quiescence search.
 // Delete as soon as MoveSort works everywhere.
-void Search::orderCaptures(const Position& pos, MoveList& moveList, const Move& ttMove) const
+void Search::orderCaptures(const Position& pos, MoveSpan& moveList, const Move& ttMove) const
 {
     for (auto i = 0; i < moveList.size(); ++i)
     {
@@ -77,31 +79,9 @@ void Search::orderCaptures(const Position& pos, MoveList& moveList, const Move&
 
 // Select the best move from a move list with selection sort.
 // Delete as soon as MoveSort works everywhere.
-Move selectMove(MoveList& moveList, int currentMove)
+Move selectMove(MoveSpan& moveList, int currentMove)
 {
-    auto bestMove = currentMove;
-    auto bestScore = moveList.getScore(currentMove);
-
-    for (auto i = currentMove + 1; i < moveList.size(); ++i)
-    {
-        if (moveList.getScore(i) > bestScore)
-        {
-            bestScore = moveList.getScore(i);
-            bestMove = i;
-        }
-    }
-
-    if (bestMove > currentMove)
-    {
-        // Swap the values at bestLocation and currentMove.
-        const auto m = moveList.getMove(currentMove);
-        const auto s = moveList.getScore(currentMove);
-        moveList.setMove(currentMove, moveList.getMove(bestMove));
-        moveList.setScore(currentMove, moveList.getScore(bestMove));
-        moveList.setMove(bestMove, m);
-        moveList.setScore(bestMove, s);
-    }
-
+    moveList.swap(currentMove, moveList.bestIndex(currentMove, moveList.size()));
     return moveList.getMove(currentMove);
 }
 
@@ -123,21 +103,24 @@ int futilityMargin(int depth)
     return 25 * depth + 100;
 }
 
-// Removes illegal moves from a moveList.
-// Remove after getting MoveSort working everywhere.
-void removeIllegalMoves(const Position& pos, MoveList& moveList, bool inCheck)
+// Removes the moves not given with searchmoves from a moveList. An empty list of moves means all moves.
+void restrictRootMoves(MoveList& moveList, const std::vector<Move>& searchMoves)
 {
     auto marker = 0;
 
     for (auto i = 0; i < moveList.size(); ++i)
     {
-        if (pos.legal(moveList.getMove(i), inCheck))
+        if (std::find(searchMoves.begin(), searchMoves.end(), moveList.getMove(i)) != searchMoves.end())
         {
             moveList.setMove(marker++, moveList.getMove(i));
         }
     }
 
-    moveList.resize(marker);
+    // If none of the moves are legal search all moves instead, we must have something to play.
+    if (marker > 0)
+    {
+        moveList.resize(marker);
+    }
 }
 
 void Search::orderRootMoves(const Position& pos, MoveList& moveList, const Move& ttMove) const
@@ -202,7 +185,8 @@ bool Search::repetitionDraw(const Position& pos, int ply) const
 {
     const auto limit = std::max(rootPly + ply - pos.getFiftyMoveDistance(), 0);
 
-    for (auto i = rootPly + ply - 2; i >= limit; i -= 2)
+    // The position two plies ago can't be the same, the opponent can't take back our move. So start from four plies ago.
+    for (auto i = rootPly + ply - 4; i >= limit; i -= 2)
     {
         if (repetitionHashes[i] == pos.getHashKey())
         {
@@ -213,6 +197,35 @@ bool Search::repetitionDraw(const Position& pos, int ply) const
     return false;
 }
 
+bool Search::upcomingRepetition(const Position& pos, const SearchStack* ss) const
+{
+    // Only positions inside the search tree are used, positions before the root have not necessarily been repeated.
+    const auto end = std::min(static_cast<int>(pos.getFiftyMoveDistance()), ss->mPly - 1);
+
+    for (auto i = 1; i <= end; ++i)
+    {
+        // The positions before a null move can't be reached with real moves.
+        if ((ss - i)->mCurrentMove.empty())
+        {
+            break;
+        }
+
+        // The position must have the other side to move, and the position three plies ago is the first one we could return to.
+        if (i < 3 || !(i & 1))
+        {
+            continue;
+        }
+
+        const auto move = Zobrist::reversibleMove(pos.getHashKey() ^ repetitionHashes[rootPly + ss->mPly - i]);
+        if (!move.empty() && !(Bitboards::squaresBetween(move.getFrom(), move.getTo()) & pos.getOccupiedSquares()))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 std::vector<Move> Search::extractPv(const Position& pos) const
 {
     Position root(pos);
@@ -241,7 +254,12 @@ std::vector<Move> Search::extractPv(const Position& pos) const
         if (entry->getFlags() != TranspositionTable::Flags::ExactScore && ply >= 2)
             break;
 
+        // Only a part of the hash key is stored in the TT so the move might be from a different position.
         const auto m = entry->getBestMove();
+        const auto inCheck = root.inCheck();
+        if (!root.pseudoLegal(m, inCheck) || !root.legal(m, inCheck))
+            break;
+
         pv.push_back(m);
         previousHashes.insert(root.getHashKey());
         root.makeMove(m);
@@ -250,6 +268,29 @@ std::vector<Move> Search::extractPv(const Position& pos) const
     return pv;
 }
 
+bool Search::saveHash(const std::string& fileName) const
+{
+    std::ofstream out(fileName, std::ios::binary);
+    return transpositionTable.save(out) && historyTable.save(out);
+}
+
+bool Search::loadHash(const std::string& fileName)
+{
+    std::ifstream in(fileName, std::ios::binary);
+    if (!transpositionTable.load(in))
+    {
+        return false;
+    }
+
+    // The killers, counter moves and pawn hash table are cheap to rebuild so they are not saved.
+    killerTable.clear();
+    counterMoveTable.clear();
+    evaluation.clearPawnHashTable();
+    // The history table is optional, the TT alone is still worth having.
+    historyTable.load(in);
+    return true;
+}
+
 void Search::go(const Position& root, const SearchParameters& sp)
 {
     std::unique_lock<std::mutex> waitLock(waitMutex);
@@ -274,7 +315,8 @@ void Search::think(const Position& root, SearchParameters sp)
 
     tbHits = 0;
     nodeCount = 0;
-    nodesToTimeCheck = 10000;
+    evaluation.resetStatistics();
+    statistics.clear();
     contempt[root.getSideToMove()] = -sp.mContempt;
     contempt[!root.getSideToMove()] = sp.mContempt;
     searchNeedsMoreTime = false;
@@ -285,6 +327,8 @@ void Search::think(const Position& root, SearchParameters sp)
     infinite = (sp.mInfinite || sp.mDepth > 0 || sp.mNodes > 0);
     const auto maxDepth = (sp.mDepth > 0 ? std::min(sp.mDepth + 1, 128) : 128);
     maxNodes = (sp.mNodes > 0 ? sp.mNodes : std::numeric_limits<size_t>::max());
+    // With a small node limit check it more often than usual, so that the limit is actually respected.
+    nodesToTimeCheck = static_cast<int>(std::min(maxNodes, static_cast<uint64_t>(10000)));
     rootPly = sp.mRootPly;
     repetitionHashes = sp.mHashKeys;
     cardinality = sp.mSyzygyProbeLimit;
@@ -326,9 +370,8 @@ void Search::think(const Position& root, SearchParameters sp)
         }
     }
 
-    inCheck ? MoveGen::generateLegalEvasions(pos, rootMoveList)
-            : MoveGen::generatePseudoLegalMoves(pos, rootMoveList);
-    removeIllegalMoves(pos, rootMoveList, inCheck);
+    MoveGen::generateLegalMoves(pos, rootMoveList);
+    restrictRootMoves(rootMoveList, sp.mSearchMoves);
 
     // Skip TB probing when no TB found: !maxCardinality -> !cardinality
     if (cardinality > Syzygy::maxCardinality)
@@ -366,10 +409,17 @@ void Search::think(const Position& root, SearchParameters sp)
     }
 
     // Get the tt move from a possible previous search.
+    // It is only used if it is one of the root moves, with searchmoves it might not be.
     const auto ttEntry = transpositionTable.probe(pos.getHashKey());
     if (ttEntry)
     {
-        bestMove = ttEntry->getBestMove();
+        for (auto i = 0; i < rootMoveList.size(); ++i)
+        {
+            if (rootMoveList.getMove(i) == ttEntry->getBestMove())
+            {
+                bestMove = ttEntry->getBestMove();
+            }
+        }
     }
 
     std::vector<SearchStack> searchStack;
@@ -379,8 +429,50 @@ void Search::think(const Position& root, SearchParameters sp)
     }
     auto ss = &searchStack[0];
 
+    // With "go mate" for a short mate first try to prove it with the dedicated mate search.
+    // The normal search is only used if there is no mate, so that we still have a move to play.
+    // The mate search always considers all root moves, so it is not used with searchmoves.
+    auto mateFound = false;
+    if (sp.mMate > 0 && sp.mMate <= mateSearchMoves && sp.mSearchMoves.empty())
+    {
+        // The mate search can't tell how far it is from finishing, so it only gets half of the time and the nodes.
+        // If it runs out, the normal search still has the rest to find a move, and it can find mates too.
+        // Without a clock "go mate" asks for nothing but the mate, so then the mate search takes as long as it needs.
+        const auto timed = !infinite && (sp.mMoveTime || sp.mTime[root.getSideToMove()]);
+        const auto mateTime = targetTime / 2;
+        const auto mateNodes = maxNodes / 2;
+        pv = mateSearch.solve(root, sp.mMate, [&](uint64_t nodes)
+        {
+            return !searching || nodes >= mateNodes
+                || (timed && !pondering && sw.elapsed<std::chrono::milliseconds>() > mateTime);
+        });
+        nodeCount += mateSearch.getNodeCount();
+        mateFound = !pv.empty();
+        if (mateFound)
+        {
+            selDepth = static_cast<int>(pv.size());
+            listener.infoPv(pv,
+                            sw.elapsed<std::chrono::milliseconds>(),
+                            nodeCount,
+                            tbHits,
+                            static_cast<int>(pv.size()),
+                            mateInPly(static_cast<int>(pv.size())),
+                            TranspositionTable::Flags::ExactScore,
+                            selDepth,
+                            transpositionTable.hashFull(),
+                            1);
+        }
+    }
+
+    // With MultiPV the lines are searched one after another at each depth.
+    // The root moves before pvIndex are the moves of the lines already found, and each line searches only the moves after them.
+    const auto multiPv = std::max(std::min(sp.mMultiPv, rootMoveList.size()), 1);
+    std::vector<std::vector<Move>> linePvs(multiPv);
+    std::vector<int> lineScores(multiPv, -infinity);
+    auto pvIndex = 0;
+
     repetitionHashes[rootPly] = pos.getHashKey();
-    for (auto depth = 1; depth < maxDepth;)
+    for (auto depth = 1; depth < maxDepth && !mateFound;)
     {
         const auto previousAlpha = alpha;
         const auto previousBeta = beta;
@@ -389,14 +481,25 @@ void Search::think(const Position& root, SearchParameters sp)
         auto movesSearched = 0;
         auto bestScore = -mateScore;
 
-        orderRootMoves(pos, rootMoveList, bestMove);
+        if (!pvIndex)
+        {
+            orderRootMoves(pos, rootMoveList, bestMove);
+            // The moves of the other lines of the previous iteration are in front, search them first in the same order.
+            for (auto j = 1; j < multiPv; ++j)
+            {
+                if (!linePvs[j].empty())
+                {
+                    rootMoveList.setScore(j, static_cast<int16_t>(hashMoveScore - j));
+                }
+            }
+        }
         try {
-            for (auto i = 0; i < rootMoveList.size(); ++i)
+            for (auto i = pvIndex; i < rootMoveList.size(); ++i)
             {
                 const auto move = selectMove(rootMoveList, i);
                 ++nodeCount;
                 --nodesToTimeCheck;
-                searchNeedsMoreTime = i > 0;
+                searchNeedsMoreTime = i > pvIndex;
 
                 // Start sending currmove info only after one second has elapsed.
                 if (sw.elapsed<std::chrono::milliseconds>() > 1000)
@@ -445,7 +548,7 @@ void Search::think(const Position& root, SearchParameters sp)
                     const auto lowerBound = score >= beta;
                     if (lowerBound)
                     {
-                        searchNeedsMoreTime = i > 0;
+                        searchNeedsMoreTime = i > pvIndex;
                         bestMove = move;
                         if (isWinScore(score))
                         {
@@ -463,7 +566,7 @@ void Search::think(const Position& root, SearchParameters sp)
                                 historyTable.addCutoff(pos, move, depth);
                                 killerTable.update(move, 0);
                             }
-                            for (auto j = 0; j < i; ++j)
+                            for (auto j = pvIndex; j < i; ++j)
                             {
                                 const auto move2 = rootMoveList.getMove(j);
                                 if (!pos.captureOrPromotion(move2))
@@ -491,7 +594,8 @@ void Search::think(const Position& root, SearchParameters sp)
                                             realScoreToTtScore(score, 0), 
                                             depth, 
                                             lowerBound ? TranspositionTable::Flags::LowerBoundScore 
-                                                       : TranspositionTable::Flags::UpperBoundScore);
+                                                       : TranspositionTable::Flags::UpperBoundScore,
+                                            -infinity);
                     pv = extractPv(pos);
                     listener.infoPv(pv, 
                                     sw.elapsed<std::chrono::milliseconds>(), 
@@ -501,7 +605,9 @@ void Search::think(const Position& root, SearchParameters sp)
                                     score, 
                                     lowerBound ? TranspositionTable::Flags::LowerBoundScore
                                                : TranspositionTable::Flags::UpperBoundScore,
-                                    selDepth);
+                                    selDepth,
+                                    transpositionTable.hashFull(),
+                                    pvIndex + 1);
                     score = newDepth > 0 ? -search<true>(newPosition, newDepth, -beta, -alpha, givesCheck != 0, ss + 1)
                                          : -quiescenceSearch(newPosition, 0, -beta, -alpha, givesCheck != 0, ss + 1);
                 }
@@ -517,7 +623,8 @@ void Search::think(const Position& root, SearchParameters sp)
                                                 bestMove, 
                                                 realScoreToTtScore(score, 0), 
                                                 depth, 
-                                                TranspositionTable::Flags::ExactScore);
+                                                TranspositionTable::Flags::ExactScore,
+                                                -infinity);
 
                         pv = extractPv(pos);
                         listener.infoPv(pv,
@@ -527,7 +634,9 @@ void Search::think(const Position& root, SearchParameters sp)
                                         depth,
                                         score,
                                         TranspositionTable::Flags::ExactScore, 
-                                        selDepth);
+                                        selDepth,
+                                        transpositionTable.hashFull(),
+                                        pvIndex + 1);
                     }
                 }
             }
@@ -541,10 +650,24 @@ void Search::think(const Position& root, SearchParameters sp)
                                 bestMove, 
                                 realScoreToTtScore(bestScore, 0), 
                                 depth, 
-                                TranspositionTable::Flags::ExactScore);
+                                TranspositionTable::Flags::ExactScore,
+                                -infinity);
 
         pv = extractPv(pos);
 
+        if (!searching && pvIndex > 0)
+        {
+            // Stopped while searching for one of the other lines, the main line of this iteration is still the result.
+            bestMove = linePvs[0][0];
+            transpositionTable.save(pos.getHashKey(), 
+                                    bestMove, 
+                                    realScoreToTtScore(lineScores[0], 0), 
+                                    depth, 
+                                    TranspositionTable::Flags::ExactScore,
+                                    -infinity);
+            pv = linePvs[0];
+        }
+
         // If there is only one root move then stop searching.
         // Not done if we are in an infinite search or pondering, since we must search for ever in those cases.
         // depth > 6 is there to make sure we have something to ponder on.
@@ -565,7 +688,58 @@ void Search::think(const Position& root, SearchParameters sp)
                         depth,
                         bestScore,
                         TranspositionTable::Flags::ExactScore,
-                        selDepth);
+                        selDepth,
+                        transpositionTable.hashFull(),
+                        pvIndex + 1);
+
+        if (multiPv > 1)
+        {
+            // Move the best move of this line in front of the moves left for the next lines.
+            for (auto i = pvIndex + 1; i < rootMoveList.size(); ++i)
+            {
+                if (rootMoveList.getMove(i) == bestMove)
+                {
+                    const auto otherScore = rootMoveList.getScore(pvIndex);
+                    rootMoveList.setMove(i, rootMoveList.getMove(pvIndex));
+                    rootMoveList.setScore(i, otherScore);
+                    rootMoveList.setMove(pvIndex, bestMove);
+                    rootMoveList.setScore(pvIndex, hashMoveScore);
+                    break;
+                }
+            }
+            linePvs[pvIndex] = pv;
+            lineScores[pvIndex] = bestScore;
+
+            if (++pvIndex < multiPv)
+            {
+                // Same depth, next line. Its window is based on its score in the previous iteration.
+                const auto lineScore = lineScores[pvIndex];
+                alpha = (depth >= 4 && !isMateScore(lineScore) ? lineScore - aspirationWindow : -infinity);
+                beta = (depth >= 4 && !isMateScore(lineScore) ? lineScore + aspirationWindow : infinity);
+                delta = aspirationWindow;
+                bestMove = (linePvs[pvIndex].empty() ? Move() : linePvs[pvIndex][0]);
+                continue;
+            }
+
+            // All lines are done, the main line is the result of this iteration.
+            pvIndex = 0;
+            bestMove = linePvs[0][0];
+            bestScore = lineScores[0];
+            pv = linePvs[0];
+            transpositionTable.save(pos.getHashKey(), 
+                                    bestMove, 
+                                    realScoreToTtScore(bestScore, 0), 
+                                    depth, 
+                                    TranspositionTable::Flags::ExactScore,
+                                    -infinity);
+        }
+
+        // With "go mate" stop as soon as the iteration proves a mate within the asked amount of moves.
+        // The score of a finished iteration is exact, fail-highs and fail-lows are searched again above.
+        if (sp.mMate > 0 && bestScore >= mateInPly(2 * sp.mMate - 1))
+        {
+            break;
+        }
 
         // Adjust alpha and beta based on the last score.
         // Don't adjust if depth is low - it's a waste of time.
@@ -616,13 +790,17 @@ int Search::search(const Position& pos, int depth, int alpha, int beta, bool inC
 
     auto bestScore = matedInPly(ss->mPly), movesSearched = 0, prunedMoves = 0;
     auto ttFlag = TranspositionTable::Flags::UpperBoundScore;
-    MoveList quietsSearched;
+    // The quiet moves searched before a cutoff get a history penalty. Moves after the first 64 are rare and do without.
+    std::array<Move, 64> quietsSearched;
+    auto quietsSearchedCount = 0;
     Move bestMove, ttMove;
     int score;
 
     // Small speed optimization, runs fine without it.
     transpositionTable.prefetch(pos.getHashKey());
 
+    statistics.increment(pvNode ? SearchStatistics::PvNodes : SearchStatistics::NonPvNodes);
+
     // Used for sending seldepth info.
     if (ss->mPly > selDepth)
     {
@@ -638,7 +816,7 @@ int Search::search(const Position& pos, int depth, int alpha, int beta, bool inC
     // Time check things.
     if (nodesToTimeCheck <= 0)
     {
-        nodesToTimeCheck = 10000;
+        nodesToTimeCheck = static_cast<int>(nodeCount < maxNodes ? std::min(maxNodes - nodeCount, static_cast<uint64_t>(10000)) : 10000);
         const auto time = sw.elapsed<std::chrono::milliseconds>();
 
         // Check if we have gone over the node limit.
@@ -668,7 +846,7 @@ int Search::search(const Position& pos, int depth, int alpha, int beta, bool inC
         if (time >= nextSendInfo)
         {
             nextSendInfo += 1000;
-            listener.infoRegular(nodeCount, tbHits, time);
+            listener.infoRegular(nodeCount, tbHits, time, transpositionTable.hashFull());
         }
     }
 
@@ -677,9 +855,9 @@ int Search::search(const Position& pos, int depth, int alpha, int beta, bool inC
     {
         if (inCheck)
         {
-            // Might as well use quietsSearched at this point, we are returning anyways.
-            MoveGen::generateLegalEvasions(pos, quietsSearched);
-            if (quietsSearched.empty())
+            StackMoveList moveList(moveStack);
+            MoveGen::generateLegalEvasions(pos, moveList);
+            if (moveList.empty())
             {
                 return bestScore; // Can't claim draw on fifty move if mated.
             }
@@ -693,6 +871,16 @@ int Search::search(const Position& pos, int depth, int alpha, int beta, bool inC
         return contempt[pos.getSideToMove()];
     }
 
+    // If we can return to an earlier position with a single move we can always get at least a draw.
+    if (alpha < contempt[pos.getSideToMove()] && upcomingRepetition(pos, ss))
+    {
+        alpha = contempt[pos.getSideToMove()];
+        if (alpha >= beta)
+        {
+            return alpha;
+        }
+    }
+
     // Mate distance pruning, safe at all types of nodes.
     alpha = std::max(matedInPly(ss->mPly), alpha);
     beta = std::min(mateInPly(ss->mPly + 1), beta);
@@ -701,8 +889,10 @@ int Search::search(const Position& pos, int depth, int alpha, int beta, bool inC
 
     // Probe the transposition table. 
     const auto ttEntry = transpositionTable.probe(pos.getHashKey());
+    statistics.increment(pvNode ? SearchStatistics::TtProbesPv : SearchStatistics::TtProbesNonPv);
     if (ttEntry)
     {
+        statistics.increment(pvNode ? SearchStatistics::TtHitsPv : SearchStatistics::TtHitsNonPv);
         ttMove = ttEntry->getBestMove();
         if (ttEntry->getDepth() >= depth)
         {
@@ -737,7 +927,10 @@ int Search::search(const Position& pos, int depth, int alpha, int beta, bool inC
     }
 
     // Get the static evaluation of the position. Not needed in nodes where we are in check.
-    const auto staticEval = (inCheck ? -infinity : evaluation.evaluate(pos));
+    // If the TT entry already contains the static evaluation there is no need to calculate it again.
+    const auto staticEval = (inCheck ? -infinity 
+                          : (ttEntry && ttEntry->getStaticEval() != -infinity) ? ttEntry->getStaticEval() 
+                          : evaluation.evaluate(pos));
 
     // Reverse futility pruning / static null move pruning.
     // Not useful in PV-nodes as this tries to search for nodes where score >= beta but in PV-nodes score < beta.
@@ -754,6 +947,7 @@ int Search::search(const Position& pos, int depth, int alpha, int beta, bool inC
         score = quiescenceSearch(pos, 0, razoringAlpha, razoringAlpha + 1, false, ss);
         if (score <= razoringAlpha)
         {
+            statistics.increment(SearchStatistics::RazoringPrunes);
             return score;
         }
     }
@@ -787,7 +981,9 @@ int Search::search(const Position& pos, int depth, int alpha, int beta, bool inC
                                         ttMove, 
                                         realScoreToTtScore(score, ss->mPly), 
                                         depth, 
-                                        TranspositionTable::Flags::LowerBoundScore);
+                                        TranspositionTable::Flags::LowerBoundScore,
+                                        staticEval);
+                statistics.increment(SearchStatistics::NullMovePrunes);
                 return score;
             }
         }
@@ -817,7 +1013,7 @@ int Search::search(const Position& pos, int depth, int alpha, int beta, bool inC
     const auto killers = killerTable.getKillers(ss->mPly);
     const auto counter = counterMoveTable.getCounterMove(pos, (ss - 1)->mCurrentMove);
 
-    MoveSort ms(pos, historyTable, ttMove, killers.first, killers.second, counter, inCheck);
+    MoveSort ms(pos, historyTable, ttMove, killers.first, killers.second, counter, inCheck, moveStack);
 
     repetitionHashes[rootPly + ss->mPly] = pos.getHashKey();
     for (auto i = 0;; ++i)
@@ -828,7 +1024,8 @@ int Search::search(const Position& pos, int depth, int alpha, int beta, bool inC
         const auto givesCheck = pos.givesCheck(move);
         const auto newDepth = depth - 1;
         const auto quietMove = !pos.captureOrPromotion(move);
-        if (quietMove) quietsSearched.emplace_back(move);
+        const auto moveStored = quietMove && quietsSearchedCount < static_cast<int>(quietsSearched.size());
+        if (moveStored) quietsSearched[quietsSearchedCount++] = move;
         const auto nonCriticalMove = !givesCheck && quietMove && move != ttMove
                                                               && move != killers.first
                                                               && move != killers.second
@@ -843,25 +1040,32 @@ int Search::search(const Position& pos, int depth, int alpha, int beta, bool inC
             {
                 bestScore = std::max(bestScore, staticEval + futilityMargin(depth));
                 ++prunedMoves;
+                statistics.increment(SearchStatistics::FutilityPrunes);
                 continue;
             }
 
             if (lmpNode && i >= lmpMoveCounts[depth])
             {
                 ++prunedMoves;
+                statistics.increment(SearchStatistics::LateMovePrunes);
                 continue;
             }
 
-            if (seePruningNode && pos.SEE(move) < 0)
+            if (seePruningNode && !pos.seeGe(move, 0))
             {
                 ++prunedMoves;
+                statistics.increment(SearchStatistics::SeePrunes);
                 continue;
             }
         }
 
-        if (!pos.legal(move, inCheck))
+        // Start loading the TT entry of the next position now, it has time to arrive while we make the move.
+        // The pawn hash table entry is only needed if the pawns change, otherwise it is already in the cache.
+        transpositionTable.prefetch(pos.hashKeyAfter(move));
+        const auto pawnHashKey = pos.pawnHashKeyAfter(move);
+        if (pawnHashKey != pos.getPawnHashKey())
         {
-            continue;
+            evaluation.prefetchPawnHashTable(pawnHashKey);
         }
 
         Position newPosition(pos);
@@ -875,6 +1079,10 @@ int Search::search(const Position& pos, int depth, int alpha, int beta, bool inC
         else
         {
             const auto reduction = ((lmrNode && nonCriticalMove) ? lmrReductions[std::min(i, 63)][std::min(depth, 63)] : 0);
+            if (reduction)
+            {
+                statistics.increment(SearchStatistics::LmrSearches);
+            }
 
             score = newDepth - reduction > 0 ? -search<false>(newPosition, newDepth - reduction, -alpha - 1, -alpha, givesCheck != 0, ss + 1)
                                              : -quiescenceSearch(newPosition, 0, -alpha - 1, -alpha, givesCheck != 0, ss + 1);
@@ -884,6 +1092,7 @@ int Search::search(const Position& pos, int depth, int alpha, int beta, bool inC
             // Before the tuned evaluation opening the window was better, after the tuned eval it is worse. Why?
             if (reduction && score > alpha)
             {
+                statistics.increment(SearchStatistics::LmrResearches);
                 score = newDepth > 0 ? -search<false>(newPosition, newDepth, -alpha - 1, -alpha, givesCheck != 0, ss + 1)
                                      : -quiescenceSearch(newPosition, 0, -alpha - 1, -alpha, givesCheck != 0, ss + 1);
             }
@@ -908,7 +1117,13 @@ int Search::search(const Position& pos, int depth, int alpha, int beta, bool inC
                                             move, 
                                             realScoreToTtScore(score, ss->mPly), 
                                             depth, 
-                                            TranspositionTable::Flags::LowerBoundScore);
+                                            TranspositionTable::Flags::LowerBoundScore,
+                                            staticEval);
+                    statistics.increment(SearchStatistics::BetaCutoffs);
+                    if (movesSearched == 1)
+                    {
+                        statistics.increment(SearchStatistics::FirstMoveBetaCutoffs);
+                    }
 
                     // Updating move ordering heuristics while in check is not good, pollutes tables.
                     if (!inCheck)
@@ -919,9 +1134,10 @@ int Search::search(const Position& pos, int depth, int alpha, int beta, bool inC
                             killerTable.update(move, ss->mPly);
                             counterMoveTable.update(pos, move, (ss - 1)->mCurrentMove);
                         }
-                        for (auto j = 0; j < quietsSearched.size() - 1; ++j)
+                        // The cutoff move itself is not penalized, it is the last stored move if it was stored at all.
+                        for (auto j = 0; j < quietsSearchedCount - (moveStored ? 1 : 0); ++j)
                         {
-                            historyTable.addNotCutoff(pos, quietsSearched.getMove(j), depth);
+                            historyTable.addNotCutoff(pos, quietsSearched[j], depth);
                         }
                     }
 
@@ -946,7 +1162,7 @@ int Search::search(const Position& pos, int depth, int alpha, int beta, bool inC
         return staticEval; 
     }
 
-    transpositionTable.save(pos.getHashKey(), bestMove, realScoreToTtScore(bestScore, ss->mPly), depth, ttFlag);
+    transpositionTable.save(pos.getHashKey(), bestMove, realScoreToTtScore(bestScore, ss->mPly), depth, ttFlag, staticEval);
 
     return bestScore;
 }
@@ -958,12 +1174,13 @@ int Search::quiescenceSearch(const Position& pos, int depth, int alpha, int beta
     assert(inCheck == pos.inCheck());
 
     int bestScore, delta;
-    MoveList moveList;
+    StackMoveList moveList(moveStack);
     Move bestMove;
     auto ttFlag = TranspositionTable::Flags::UpperBoundScore;
 
     // Small speed optimization, runs fine without it.
     transpositionTable.prefetch(pos.getHashKey());
+    statistics.increment(SearchStatistics::QuiescenceNodes);
 
     // Don't go over max ply.
     if (ss->mPly >= maxPly)
@@ -991,6 +1208,16 @@ int Search::quiescenceSearch(const Position& pos, int depth, int alpha, int beta
         return contempt[pos.getSideToMove()];
     }
 
+    // Same as in the main search.
+    if (alpha < contempt[pos.getSideToMove()] && upcomingRepetition(pos, ss))
+    {
+        alpha = contempt[pos.getSideToMove()];
+        if (alpha >= beta)
+        {
+            return alpha;
+        }
+    }
+
     // Mate distance pruning, safe at all types of nodes.
     alpha = std::max(matedInPly(ss->mPly), alpha);
     beta = std::min(mateInPly(ss->mPly + 1), beta);
@@ -1003,8 +1230,10 @@ int Search::quiescenceSearch(const Position& pos, int depth, int alpha, int beta
     const auto ttDepth = (inCheck || depth >= 0) ? 0 : -1;
 
     const auto ttEntry = transpositionTable.probe(pos.getHashKey());
+    statistics.increment(SearchStatistics::TtProbesQuiescence);
     if (ttEntry)
     {
+        statistics.increment(SearchStatistics::TtHitsQuiescence);
         bestMove = ttEntry->getBestMove();
         if (ttEntry->getDepth() >= ttDepth)
         {
@@ -1041,8 +1270,8 @@ int Search::quiescenceSearch(const Position& pos, int depth, int alpha, int beta
             alpha = bestScore;
         }
         delta = bestScore + deltaPruningMargin;
-        depth >= 0 ? MoveGen::generatePseudoLegalCapturesAndQuietChecks(pos, moveList)
-                   : MoveGen::generatePseudoLegalCaptures(pos, moveList, false);
+        depth >= 0 ? MoveGen::generateLegalCapturesAndQuietChecks(pos, moveList)
+                   : MoveGen::generateLegalCaptures(pos, moveList, false);
     }
 
     orderCaptures(pos, moveList, bestMove);
@@ -1055,29 +1284,31 @@ int Search::quiescenceSearch(const Position& pos, int depth, int alpha, int beta
         --nodesToTimeCheck;
 
         // Only prune moves in quiescence search if we are not in check.
-        if (!inCheck)
+        // Since the SEE score is meaningless for discovered checks we don't prune them.
+        if (!inCheck && givesCheck != 2)
         {
-            const auto seeScore = pos.SEE(move);
-
             // SEE pruning. If the move seems to lose material prune it.
-            // Since the SEE score is meaningless for discovered checks we don't prune them.
-            if (seeScore < 0 && givesCheck != 2)
+            if (!pos.seeGe(move, 0))
             {
                 continue;
             }
 
             // Delta pruning. If the move seems to have no chance of raising alpha prune it.
             // Pruning checks here is too dangerous.
-            if (delta + seeScore <= alpha && !givesCheck)
+            // The exact SEE score is only needed for the pruned moves.
+            if (!givesCheck && !pos.seeGe(move, alpha - delta + 1))
             {
-                bestScore = std::max(bestScore, delta + seeScore);
+                bestScore = std::max(bestScore, delta + pos.SEE(move));
                 continue;
             }
         }
 
-        if (!pos.legal(move, inCheck))
+        // Same as in the main search.
+        transpositionTable.prefetch(pos.hashKeyAfter(move));
+        const auto pawnHashKey = pos.pawnHashKeyAfter(move);
+        if (pawnHashKey != pos.getPawnHashKey())
         {
-            continue;
+            evaluation.prefetchPawnHashTable(pawnHashKey);
         }
 
         Position newPosition(pos);
@@ -1094,7 +1325,8 @@ int Search::quiescenceSearch(const Position& pos, int depth, int alpha, int beta
                                             move,
                                             realScoreToTtScore(score, ss->mPly),
                                             ttDepth,
-                                            TranspositionTable::Flags::LowerBoundScore);
+                                            TranspositionTable::Flags::LowerBoundScore,
+                                            -infinity);
                     return score;
                 }
                 bestMove = move;
@@ -1109,7 +1341,8 @@ int Search::quiescenceSearch(const Position& pos, int depth, int alpha, int beta
                             bestMove, 
                             realScoreToTtScore(bestScore, ss->mPly), 
                             ttDepth, 
-                            ttFlag);
+                            ttFlag,
+                            -infinity);
 
     return bestScore;
 }
\ No newline at end of file
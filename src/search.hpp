@@ -26,6 +26,7 @@
 #include "tt.hpp"
 #include "history.hpp"
 #include "killer.hpp"
+#include "mate_search.hpp"
 #include "counter.hpp"
 #include "evaluation.hpp"
 #include "pht.hpp"
@@ -33,7 +34,9 @@
 #include "utils/threadpool.hpp"
 #include "search_listener.hpp"
 #include "search_parameters.hpp"
+#include "search_statistics.hpp"
 #include "movelist.hpp"
+#include "movestack.hpp"
 
 /// @brief The core of this program, the search function.
 class Search
@@ -52,17 +55,42 @@ public:
     /// Usually the blocking time is very short, 5-10ms at most.
     void go(const Position& root, const SearchParameters& sp);
 
-    /// @brief Clears the TT, PHT, killer table, history table and the counter move table. 
+    /// @brief Clears the TT, PHT, killer table, history table, counter move table and the table of the mate search. 
     ///
     /// Can take a long time with very large TT and PHT.
     void clearSearch();
 
+    /// @brief Saves the TT and the history table to a file, so that a long analysis can be continued later.
+    /// @param fileName The name of the file.
+    /// @return True if succesful.
+    bool saveHash(const std::string& fileName) const;
+
+    /// @brief Loads the TT and the history table from a file written by saveHash. The size of the TT changes to the size of the saved one.
+    /// @param fileName The name of the file.
+    /// @return True if at least the TT was loaded succesfully. On failure the other tables are left untouched, the TT is only cleared if the file ends in the middle of it.
+    ///
+    /// Reading is limited by the disk speed, the table is read directly into place.
+    bool loadHash(const std::string& fileName);
+
+    /// @brief Get the size of the TT. Only differs from the size set with setTranspositionTableSize after loadHash.
+    /// @return The size in megabytes.
+    size_t getTranspositionTableSize() const;
+
     /// @brief Used for setting the size of the TT. 
     /// @param sizeInMegaBytes The new size of the TT.
     ///
     /// Can take a long time with a large value of sizeInMegaBytes.
     void setTranspositionTableSize(size_t sizeInMegaBytes);
 
+    /// @brief Makes the TT shared with the other processes using the same name.
+    /// @param name The name of the shared TT.
+    /// @param sizeInMegaBytes The size of the shared TT if this process is the first to use it.
+    /// @return True if succesful, if not a private TT of the given size is used.
+    bool setSharedTranspositionTable(const std::string& name, size_t sizeInMegaBytes);
+
+    /// @brief Stops sharing the TT with other processes without unmapping it. Must be called before exiting the program with exit().
+    void releaseSharedTranspositionTable();
+
     /// @brief Used for setting the size of the PHT. 
     /// @param sizeInMegaBytes The new size of the PHT.
     ///
@@ -79,6 +107,10 @@ public:
     /// @brief Stop pondering. This does not mean stopping the search.
     void stopPondering();
 
+    /// @brief Get the statistics of the current or the last search.
+    /// @return The statistics. All zero unless the program was compiled with SEARCH_STATISTICS defined.
+    SearchStatistics getStatistics() const;
+
 private:
     // A stack used for holding information which needs to be accessible to other levels of recursion.
     struct SearchStack
@@ -101,6 +133,8 @@ private:
     KillerTable killerTable;
     CounterMoveTable counterMoveTable;
     HistoryTable historyTable;
+    MateSearch mateSearch;
+    MoveStack moveStack;
     SearchListener& listener;
     Stopwatch sw;
 
@@ -123,6 +157,7 @@ private:
     uint64_t tbHits;
     uint64_t nodeCount;
     int selDepth;
+    SearchStatistics statistics;
 
     // Flags related to stopping the search.
     bool searching;
@@ -142,6 +177,9 @@ private:
     int rootPly;
     std::vector<HashKey> repetitionHashes;
     bool repetitionDraw(const Position& pos, int ply) const;
+    // Checks if the side to move can return to a position which occured during the search with a single reversible move.
+    // Uses the cuckoo table of reversible moves in Zobrist, so the cost is only a couple of lookups per position in the history.
+    bool upcomingRepetition(const Position& pos, const SearchStack* ss) const;
 
     // Used for changing the values of draws inside the search.
     std::array<int, 2> contempt;
@@ -160,7 +198,7 @@ private:
     void orderRootMoves(const Position& pos, MoveList& moveList, const Move& ttMove) const;
 
     // Used for ordering captures in the quiescence search.
-    void orderCaptures(const Position& pos, MoveList& moveList, const Move& ttMove) const;
+    void orderCaptures(const Position& pos, MoveSpan& moveList, const Move& ttMove) const;
 
     // Used for getting the PV out of the TT:
     std::vector<Move> extractPv(const Position& root) const;
@@ -173,6 +211,7 @@ inline void Search::clearSearch()
     killerTable.clear(); 
     historyTable.clear();
     counterMoveTable.clear();
+    mateSearch.clear();
 }
 
 inline void Search::setTranspositionTableSize(size_t sizeInMegaBytes)
@@ -180,6 +219,21 @@ inline void Search::setTranspositionTableSize(size_t sizeInMegaBytes)
     transpositionTable.setSize(sizeInMegaBytes);
 }
 
+inline size_t Search::getTranspositionTableSize() const
+{
+    return transpositionTable.getSize();
+}
+
+inline bool Search::setSharedTranspositionTable(const std::string& name, size_t sizeInMegaBytes)
+{
+    return transpositionTable.attach(name, sizeInMegaBytes);
+}
+
+inline void Search::releaseSharedTranspositionTable()
+{
+    transpositionTable.releaseShared();
+}
+
 inline void Search::setPawnHashTableSize(size_t sizeInMegaBytes)
 { 
     evaluation.setPawnHashTableSize(sizeInMegaBytes);
@@ -200,4 +254,18 @@ inline void Search::stopPondering()
     pondering = false;
 }
 
+inline SearchStatistics Search::getStatistics() const
+{
+    // The pawn hash table and TT replacement counters are kept by the classes doing the work.
+    auto stats = statistics;
+    stats.set(SearchStatistics::PhtProbes, evaluation.getPawnHashTableProbes());
+    stats.set(SearchStatistics::PhtHits, evaluation.getPawnHashTableHits());
+    stats.set(SearchStatistics::TtReplacedEmpty, transpositionTable.getReplacements(TranspositionTable::ReplacedEmpty));
+    stats.set(SearchStatistics::TtReplacedSameKey, transpositionTable.getReplacements(TranspositionTable::ReplacedSameKey));
+    stats.set(SearchStatistics::TtReplacedOlderGeneration, transpositionTable.getReplacements(TranspositionTable::ReplacedOlderGeneration));
+    stats.set(SearchStatistics::TtReplacedShallower, transpositionTable.getReplacements(TranspositionTable::ReplacedShallower));
+    stats.set(SearchStatistics::TtReplacedDeeper, transpositionTable.getReplacements(TranspositionTable::ReplacedDeeper));
+    return stats;
+}
+
 #endif
\ No newline at end of file
@@ -24,6 +24,7 @@
 #include <array>
 #include <vector>
 #include "move.hpp"
+#include "zobrist.hpp"
 
 /// @brief Contains options for the search function.
 struct SearchParameters 
@@ -83,12 +84,15 @@ struct SearchParameters
 
     /// @brief Whether we should use the 50-move rule with Syzygys or not.
     bool mSyzygy50MoveRule;
+
+    /// @brief The amount of best root moves to find principal variations for.
+    int mMultiPv;
 };
 
 inline SearchParameters::SearchParameters():
     mPonder(false), mPonderOption(false), mContempt(0), mTime({ { 0, 0 } }), mIncrement({ { 0, 0 } }),
     mMovesToGo(25), mDepth(0), mNodes(0), mMate(0), mMoveTime(0), mInfinite(false), mRootPly(0),
-    mSyzygyProbeDepth(1), mSyzygyProbeLimit(6), mSyzygy50MoveRule(true)
+    mSyzygyProbeDepth(1), mSyzygyProbeLimit(6), mSyzygy50MoveRule(true), mMultiPv(1)
 {
 };
 
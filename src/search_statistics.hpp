@@ -0,0 +1,175 @@
+/*
+    Hakkapeliitta - A UCI chess engine. Copyright (C) 2013-2015 Mikko Aarnos.
+
+    Hakkapeliitta is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Hakkapeliitta is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Hakkapeliitta. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/// @file search_statistics.hpp
+/// @author Mikko Aarnos
+
+#ifndef SEARCH_STATISTICS_HPP_
+#define SEARCH_STATISTICS_HPP_
+
+#include <cstdint>
+#include <array>
+#include <iostream>
+#include <iomanip>
+#include <string>
+
+/// @brief Counters used for finding out why the search behaves like it does.
+///
+/// The counters are only collected if the program is compiled with SEARCH_STATISTICS defined.
+/// Otherwise incrementing a counter compiles to nothing.
+class SearchStatistics
+{
+public:
+    /// @brief The different things we count.
+    enum Counter
+    {
+        PvNodes, NonPvNodes, QuiescenceNodes,
+        TtProbesPv, TtHitsPv, TtProbesNonPv, TtHitsNonPv, TtProbesQuiescence, TtHitsQuiescence,
+        BetaCutoffs, FirstMoveBetaCutoffs,
+        NullMovePrunes, RazoringPrunes, FutilityPrunes, LateMovePrunes, SeePrunes,
+        LmrSearches, LmrResearches,
+        PhtProbes, PhtHits,
+        TtReplacedEmpty, TtReplacedSameKey, TtReplacedOlderGeneration, TtReplacedShallower, TtReplacedDeeper,
+        NumberOfCounters
+    };
+
+#ifdef SEARCH_STATISTICS
+    static const bool enabled = true;
+#else
+    static const bool enabled = false;
+#endif
+
+    /// @brief Default constructor.
+    SearchStatistics() noexcept;
+
+    /// @brief Increments a given counter. Does nothing if statistics are not enabled.
+    /// @param c The counter.
+    void increment(Counter c) noexcept;
+
+    /// @brief Sets a given counter to a given value. Does nothing if statistics are not enabled.
+    /// @param c The counter.
+    /// @param value The new value.
+    void set(Counter c, uint64_t value) noexcept;
+
+    /// @brief Get the value of a given counter.
+    /// @param c The counter.
+    /// @return The value.
+    uint64_t get(Counter c) const noexcept;
+
+    /// @brief Sets all counters to zero.
+    void clear() noexcept;
+
+    /// @brief Used for aggregating the statistics of multiple threads.
+    /// @param other The statistics to add to these.
+    /// @return A reference to this object.
+    SearchStatistics& operator+=(const SearchStatistics& other) noexcept;
+
+private:
+    std::array<uint64_t, NumberOfCounters> mCounters;
+};
+
+inline SearchStatistics::SearchStatistics() noexcept
+{
+    clear();
+}
+
+inline void SearchStatistics::increment(Counter c) noexcept
+{
+    if (enabled)
+    {
+        ++mCounters[c];
+    }
+}
+
+inline void SearchStatistics::set(Counter c, uint64_t value) noexcept
+{
+    if (enabled)
+    {
+        mCounters[c] = value;
+    }
+}
+
+inline uint64_t SearchStatistics::get(Counter c) const noexcept
+{
+    return mCounters[c];
+}
+
+inline void SearchStatistics::clear() noexcept
+{
+    mCounters.fill(0);
+}
+
+inline SearchStatistics& SearchStatistics::operator+=(const SearchStatistics& other) noexcept
+{
+    for (auto i = 0; i < NumberOfCounters; ++i)
+    {
+        mCounters[i] += other.mCounters[i];
+    }
+    return *this;
+}
+
+/// @brief Used for printing search statistics into a ostream.
+/// @param out The ostream to print to.
+/// @param stats The statistics to print.
+/// @return A reference to the ostream to allow chaining.
+inline std::ostream& operator<<(std::ostream& out, const SearchStatistics& stats)
+{
+    if (!SearchStatistics::enabled)
+    {
+        out << "info string search statistics are not enabled, compile with -DSEARCH_STATISTICS" << std::endl;
+        return out;
+    }
+
+    const auto count = [&out](const std::string& name, uint64_t value)
+    {
+        out << "info string " << std::left << std::setw(24) << name << std::right << std::setw(14) << value << std::endl;
+    };
+    const auto ratio = [&out](const std::string& name, uint64_t part, uint64_t total)
+    {
+        out << "info string " << std::left << std::setw(24) << name << std::right << std::setw(14) << part << " / " << total
+            << " (" << std::fixed << std::setprecision(2) << (total ? 100.0 * part / total : 0.0) << "%)" << std::endl;
+    };
+    const auto nodes = stats.get(SearchStatistics::PvNodes) + stats.get(SearchStatistics::NonPvNodes)
+                     + stats.get(SearchStatistics::QuiescenceNodes);
+
+    ratio("pv nodes", stats.get(SearchStatistics::PvNodes), nodes);
+    ratio("non-pv nodes", stats.get(SearchStatistics::NonPvNodes), nodes);
+    ratio("qsearch nodes", stats.get(SearchStatistics::QuiescenceNodes), nodes);
+    ratio("tt hits pv", stats.get(SearchStatistics::TtHitsPv), stats.get(SearchStatistics::TtProbesPv));
+    ratio("tt hits non-pv", stats.get(SearchStatistics::TtHitsNonPv), stats.get(SearchStatistics::TtProbesNonPv));
+    ratio("tt hits qsearch", stats.get(SearchStatistics::TtHitsQuiescence), stats.get(SearchStatistics::TtProbesQuiescence));
+    ratio("first move cutoffs", stats.get(SearchStatistics::FirstMoveBetaCutoffs), stats.get(SearchStatistics::BetaCutoffs));
+    ratio("null move prunes", stats.get(SearchStatistics::NullMovePrunes), stats.get(SearchStatistics::NonPvNodes));
+    ratio("razoring prunes", stats.get(SearchStatistics::RazoringPrunes), stats.get(SearchStatistics::NonPvNodes));
+    count("futility prunes", stats.get(SearchStatistics::FutilityPrunes));
+    count("late move prunes", stats.get(SearchStatistics::LateMovePrunes));
+    count("see prunes", stats.get(SearchStatistics::SeePrunes));
+    ratio("lmr re-searches", stats.get(SearchStatistics::LmrResearches), stats.get(SearchStatistics::LmrSearches));
+    ratio("pht hits", stats.get(SearchStatistics::PhtHits), stats.get(SearchStatistics::PhtProbes));
+    const auto ttReplacements = stats.get(SearchStatistics::TtReplacedEmpty) + stats.get(SearchStatistics::TtReplacedSameKey)
+                              + stats.get(SearchStatistics::TtReplacedOlderGeneration) + stats.get(SearchStatistics::TtReplacedShallower)
+                              + stats.get(SearchStatistics::TtReplacedDeeper);
+    ratio("tt replaced empty", stats.get(SearchStatistics::TtReplacedEmpty), ttReplacements);
+    ratio("tt replaced same key", stats.get(SearchStatistics::TtReplacedSameKey), ttReplacements);
+    ratio("tt replaced older", stats.get(SearchStatistics::TtReplacedOlderGeneration), ttReplacements);
+    ratio("tt replaced shallower", stats.get(SearchStatistics::TtReplacedShallower), ttReplacements);
+    ratio("tt replaced deeper", stats.get(SearchStatistics::TtReplacedDeeper), ttReplacements);
+
+    return out;
+}
+
+#endif
@@ -0,0 +1,168 @@
+/*
+    Hakkapeliitta - A UCI chess engine. Copyright (C) 2013-2015 Mikko Aarnos.
+
+    Hakkapeliitta is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Hakkapeliitta is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Hakkapeliitta. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "selfplay.hpp"
+#include <algorithm>
+#include <functional>
+#include <random>
+#include <thread>
+#include "movegen.hpp"
+#include "result_listener.hpp"
+#include "search.hpp"
+
+// Games are adjudicated when the score goes over this, low node searches can take a long time to actually mate.
+const int adjudicationScore = 1500;
+
+// Games which last longer than this are declared drawn.
+const int maxGamePly = 400;
+
+SelfPlay::SelfPlay(const std::string& outputFileName) :
+    mOutputFile(outputFileName, std::ios::binary | std::ios::app), mPositionsWanted(0), mPositionsWritten(0)
+{
+}
+
+uint64_t SelfPlay::run(const SearchParameters& sp, int threads, uint64_t positions, int randomPlies,
+                       size_t transpositionTableSize, size_t pawnHashTableSize)
+{
+    std::vector<std::thread> workers;
+    mPositionsWanted = positions;
+    mPositionsWritten = 0;
+
+    for (auto i = 0; i < threads; ++i)
+    {
+        workers.emplace_back(&SelfPlay::worker, this, std::cref(sp), randomPlies,
+                             std::max(transpositionTableSize / threads, static_cast<size_t>(1)), pawnHashTableSize);
+    }
+
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+
+    mOutputFile.flush();
+    return mPositionsWritten;
+}
+
+bool SelfPlay::writePositions(const std::vector<PackedPosition>& positions)
+{
+    std::unique_lock<std::mutex> lock(mFileMutex);
+
+    const auto amount = std::min(static_cast<uint64_t>(positions.size()), mPositionsWanted - mPositionsWritten);
+    mOutputFile.write(reinterpret_cast<const char*>(positions.data()), static_cast<std::streamsize>(amount * sizeof(PackedPosition)));
+    mPositionsWritten += amount;
+
+    return mPositionsWritten < mPositionsWanted;
+}
+
+void SelfPlay::worker(const SearchParameters& sp, int randomPlies, size_t transpositionTableSize, size_t pawnHashTableSize)
+{
+    ResultListener listener;
+    Search search(listener);
+    search.setTranspositionTableSize(transpositionTableSize);
+    search.setPawnHashTableSize(pawnHashTableSize);
+
+    SearchParameters searchParameters(sp);
+    searchParameters.mHashKeys.assign(1024, 0);
+    std::mt19937 rng(std::random_device{}());
+
+    for (;;)
+    {
+        Position pos("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+        std::vector<PackedPosition> positions;
+        std::vector<Color> sidesToMove;
+        auto result = static_cast<int8_t>(PackedPosition::Draw);
+
+        search.clearSearch();
+        for (auto ply = 0; ply < maxGamePly; ++ply)
+        {
+            MoveList moveList;
+            const auto inCheck = pos.inCheck();
+            inCheck ? MoveGen::generateLegalEvasions(pos, moveList) : MoveGen::generatePseudoLegalMoves(pos, moveList);
+            std::vector<Move> legalMoves;
+            for (auto i = 0; i < moveList.size(); ++i)
+            {
+                if (pos.legal(moveList.getMove(i), inCheck))
+                {
+                    legalMoves.push_back(moveList.getMove(i));
+                }
+            }
+
+            // Checkmate or stalemate.
+            if (legalMoves.empty())
+            {
+                result = (inCheck ? PackedPosition::Loss : PackedPosition::Draw);
+                break;
+            }
+
+            // Fifty-move rule, threefold repetition and bare kings.
+            auto repetitions = 0;
+            for (auto i = ply - 2; i >= std::max(ply - pos.getFiftyMoveDistance(), 0); i -= 2)
+            {
+                repetitions += (searchParameters.mHashKeys[i] == pos.getHashKey());
+            }
+            if (pos.getFiftyMoveDistance() >= 100 || repetitions >= 2 || pos.getTotalPieceCount() == 2)
+            {
+                break;
+            }
+
+            searchParameters.mHashKeys[ply] = pos.getHashKey();
+            if (ply < randomPlies)
+            {
+                pos.makeMove(legalMoves[std::uniform_int_distribution<size_t>(0, legalMoves.size() - 1)(rng)]);
+                continue;
+            }
+
+            searchParameters.mRootPly = ply;
+            listener.reset();
+            search.go(pos, searchParameters);
+            listener.waitForBestMove();
+
+            if (listener.mPv.empty())
+            {
+                break;
+            }
+
+            const auto score = listener.mScore;
+            if (std::abs(score) >= adjudicationScore)
+            {
+                result = (score > 0 ? PackedPosition::Win : PackedPosition::Loss);
+                break;
+            }
+
+            // Only quiet positions are useful for tuning, as the evaluation function is only called in quiet positions.
+            const auto move = listener.mPv[0];
+            if (!inCheck && !pos.captureOrPromotion(move))
+            {
+                positions.emplace_back(pos, static_cast<int16_t>(score));
+                sidesToMove.push_back(pos.getSideToMove());
+            }
+
+            pos.makeMove(move);
+        }
+
+        // The result is from the point of view of the side to move in the final position, turn it to the point of view of each position.
+        for (size_t i = 0; i < positions.size(); ++i)
+        {
+            positions[i].setResult(static_cast<int8_t>(sidesToMove[i] == pos.getSideToMove() ? result : -result));
+        }
+
+        if (!writePositions(positions))
+        {
+            break;
+        }
+    }
+}
@@ -0,0 +1,74 @@
+/*
+    Hakkapeliitta - A UCI chess engine. Copyright (C) 2013-2015 Mikko Aarnos.
+
+    Hakkapeliitta is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Hakkapeliitta is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Hakkapeliitta. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/// @file selfplay.hpp
+/// @author Mikko Aarnos
+
+#ifndef SELFPLAY_HPP_
+#define SELFPLAY_HPP_
+
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "packed_position.hpp"
+#include "search_parameters.hpp"
+
+/// @brief Used for generating labelled positions for tuning the evaluation function by playing games against itself.
+///
+/// Every thread plays its own games with its own search function.
+/// The quiet positions of each game are appended to the output file as PackedPositions once the game is over and the result is known.
+class SelfPlay
+{
+public:
+    /// @brief Constructs a new self-play session.
+    /// @param outputFileName The file to append the positions to.
+    SelfPlay(const std::string& outputFileName);
+
+    /// @brief Checks if the output file was opened succesfully.
+    /// @return True if the file is open.
+    bool isOpen() const;
+
+    /// @brief Plays games until enough positions have been written.
+    /// @param sp The parameters given to each search. Should contain a depth or node limit.
+    /// @param threads The amount of games played at the same time.
+    /// @param positions The amount of positions to write.
+    /// @param randomPlies The amount of random moves played at the start of each game.
+    /// @param transpositionTableSize The total size of the TTs in megabytes, divided evenly between the threads.
+    /// @param pawnHashTableSize The size of the PHT of each thread in megabytes.
+    /// @return The amount of positions written.
+    uint64_t run(const SearchParameters& sp, int threads, uint64_t positions, int randomPlies,
+                 size_t transpositionTableSize, size_t pawnHashTableSize);
+
+private:
+    void worker(const SearchParameters& sp, int randomPlies, size_t transpositionTableSize, size_t pawnHashTableSize);
+
+    // Writes the positions of a finished game. Returns false if enough positions have been written.
+    bool writePositions(const std::vector<PackedPosition>& positions);
+
+    std::ofstream mOutputFile;
+    std::mutex mFileMutex;
+    uint64_t mPositionsWanted;
+    uint64_t mPositionsWritten;
+};
+
+inline bool SelfPlay::isOpen() const
+{
+    return mOutputFile.is_open();
+}
+
+#endif
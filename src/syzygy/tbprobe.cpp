@@ -709,6 +709,22 @@ bool Syzygy::rootProbe(const Position& pos, MoveList& rootMoves, int& score)
         rootMoves.setScore(i, static_cast<int16_t>(v));
     }
 
+    // With searchmoves we might only have some of the moves, and the best of them can be worse than the root position.
+    // In that case filter according to the best move we do have, otherwise we would filter out every move.
+    auto win = false, draw = false;
+    int longestLoss = 0;
+    for (auto i = 0; i < rootMoves.size(); i++)
+    {
+        int v = rootMoves.getScore(i);
+        win |= (v > 0);
+        draw |= (v == 0);
+        longestLoss = std::min(longestLoss, v);
+    }
+    if (dtz > 0 && !win)
+        dtz = (draw ? 0 : longestLoss);
+    else if (dtz == 0 && !draw)
+        dtz = longestLoss;
+
     // Obtain 50-move counter for the root position.
     int cnt50 = pos.getFiftyMoveDistance();
 
@@ -815,6 +831,10 @@ bool Syzygy::rootProbeWdl(const Position& pos, MoveList& rootMoves, int& score)
             best = v;
     }
 
+    // With searchmoves the best move we have can be worse than the root position.
+    if (best < score)
+        score = best;
+
     auto j = 0;
     for (auto i = 0; i < rootMoves.size(); i++)
     {
@@ -87,6 +87,19 @@ bool Testing::testReversedEval() const
     return true;
 }
 
+bool Testing::testPawnStructure() const
+{
+    for (const auto& s : positions)
+    {
+        if (!Evaluation::checkPawnStructure(Position(s)) || !Evaluation::checkPawnStructure(Position(flipFenString(s))))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
 bool Testing::testPseudoLegal() const
 {
     for (const auto& s : positions)
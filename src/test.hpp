@@ -35,6 +35,10 @@ public:
     /// @return True if everything is okay, false otherwise.
     bool testReversedEval() const;
 
+    /// @brief Used for checking that the set-wise pawn structure evaluation matches the pawn-by-pawn one, with colors flipped as well.
+    /// @return True if everything is okay, false otherwise.
+    bool testPawnStructure() const;
+
     /// @brief Used for checking that the function for checking if a move is pseudo legal is correct.
     /// @return True if everything is okay, false otherwise.
     bool testPseudoLegal() const;
@@ -24,6 +24,7 @@
 #include <sstream>
 #include "position.hpp"
 #include "constants.hpp"
+#include "movegen.hpp"
 
 /// @brief Used for printin a Position into a ostream.
 /// @param out The ostream to print to.
@@ -181,6 +182,134 @@ inline std::string moveToUciFormat(const Move& move)
     return s;
 }
 
+/// @brief Used for converting a move in UCI-format into a move.
+/// @param pos The position the move is made in.
+/// @param s The move as a string.
+/// @return The move. Not checked for legality, the move is only as good as the string.
+inline Move uciFormatToMove(const Position& pos, const std::string& s)
+{
+    if (s.size() < 4)
+    {
+        return Move();
+    }
+
+    Piece promotion = Piece::Empty;
+    const auto from = (s[0] - 'a') + 8 * (s[1] - '1');
+    const auto to = (s[2] - 'a') + 8 * (s[3] - '1');
+    if (from < 0 || from > 63 || to < 0 || to > 63)
+    {
+        return Move();
+    }
+
+    if (s.size() == 5)
+    {
+        switch (s[4])
+        {
+            case 'q': promotion = Piece::Queen; break;
+            case 'r': promotion = Piece::Rook; break;
+            case 'b': promotion = Piece::Bishop; break;
+            case 'n': promotion = Piece::Knight; break;
+            default:;
+        }
+    }
+    else if (pos.getBoard(from).getPieceType() == Piece::King && std::abs(from - to) == 2)
+    {
+        promotion = Piece::King;
+    }
+    else if (pos.getBoard(from).getPieceType() == Piece::Pawn && to == pos.getEnPassantSquare())
+    {
+        promotion = Piece::Pawn;
+    }
+
+    return Move(from, to, promotion);
+}
+
+/// @brief Used for converting a move into standard algebraic notation (SAN).
+/// @param pos The position the move is made in.
+/// @param move The move, must be legal in the position.
+/// @return The move as a string.
+inline std::string moveToSanFormat(const Position& pos, const Move& move)
+{
+    static const auto pieceToMark = "PNBRQK";
+    const auto from = move.getFrom();
+    const auto to = move.getTo();
+    const auto flags = move.getFlags();
+    const auto pieceType = pos.getBoard(from).getPieceType();
+    const auto capture = (pos.getBoard(to) != Piece::Empty || (pieceType == Piece::Pawn && flags == Piece::Pawn));
+    const auto inCheck = pos.inCheck();
+    const std::string destination = { static_cast<char>('a' + file(to)), static_cast<char>('1' + rank(to)) };
+    std::string s;
+
+    if (pieceType == Piece::King && flags == Piece::King)
+    {
+        s = (file(to) > file(from) ? "O-O" : "O-O-O");
+    }
+    else if (pieceType == Piece::Pawn)
+    {
+        if (capture)
+        {
+            s += static_cast<char>('a' + file(from));
+            s += 'x';
+        }
+        s += destination;
+        if (flags != Piece::Empty && flags != Piece::Pawn)
+        {
+            s += '=';
+            s += pieceToMark[flags];
+        }
+    }
+    else
+    {
+        // If another piece of the same type can move to the same square add the file, rank or both of the from-square.
+        MoveList moveList;
+        auto sameFile = false, sameRank = false, ambiguous = false;
+        inCheck ? MoveGen::generateLegalEvasions(pos, moveList) : MoveGen::generatePseudoLegalMoves(pos, moveList);
+        for (auto i = 0; i < moveList.size(); ++i)
+        {
+            const auto other = moveList.getMove(i);
+            if (other.getTo() == to && other.getFrom() != from 
+                && pos.getBoard(other.getFrom()).getPieceType() == pieceType && pos.legal(other, inCheck))
+            {
+                ambiguous = true;
+                sameFile = sameFile || file(other.getFrom()) == file(from);
+                sameRank = sameRank || rank(other.getFrom()) == rank(from);
+            }
+        }
+
+        s += pieceToMark[pieceType];
+        if (ambiguous && (!sameFile || sameRank))
+        {
+            s += static_cast<char>('a' + file(from));
+        }
+        if (ambiguous && sameFile)
+        {
+            s += static_cast<char>('1' + rank(from));
+        }
+        if (capture)
+        {
+            s += 'x';
+        }
+        s += destination;
+    }
+
+    // Add the check or mate mark.
+    Position newPosition(pos);
+    newPosition.makeMove(move);
+    if (newPosition.inCheck())
+    {
+        MoveList replies;
+        auto legalReplies = 0;
+        MoveGen::generateLegalEvasions(newPosition, replies);
+        for (auto i = 0; i < replies.size(); ++i)
+        {
+            legalReplies += newPosition.legal(replies.getMove(i), true);
+        }
+        s += (legalReplies ? '+' : '#');
+    }
+
+    return s;
+}
+
 /// @brief Used for converting multiple moves into UCI-format.
 /// @param moves A list of moves.
 /// @return The moves as a string. 
@@ -19,13 +19,25 @@
 #include "bitboards.hpp"
 #include <cassert>
 #include <cmath>
+#include <algorithm>
+#include <chrono>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <thread>
 #include <unordered_set>
 
-TranspositionTable::TranspositionTable()
+TranspositionTable::TranspositionTable() :
+    mTable(nullptr), mTableSize(0)
 {
     setSize(32); 
 }
 
+TranspositionTable::~TranspositionTable()
+{
+    detach();
+}
+
 void TranspositionTable::setSize(size_t sizeInMegaBytes)
 {
     // If size is not a power of two make it the biggest power of two smaller than size.
@@ -34,24 +46,128 @@ void TranspositionTable::setSize(size_t sizeInMegaBytes)
         sizeInMegaBytes = static_cast<size_t>(std::pow(2, std::floor(log2(sizeInMegaBytes))));
     }
 
-    const auto tableSize = ((sizeInMegaBytes * 1024 * 1024) / sizeof(std::array<TranspositionTableEntry, 4>));
-    mTable.clear();
-    mTable.resize(tableSize);
-    mTable.shrink_to_fit();
+    detach();
+    allocate((sizeInMegaBytes * 1024 * 1024) / sizeof(Bucket));
     mGeneration = 1;
+    mReplacements.fill(0);
+}
+
+bool TranspositionTable::attach(const std::string& name, size_t sizeInMegaBytes)
+{
+    if (Bitboards::moreThanOneBitSet(sizeInMegaBytes))
+    {
+        sizeInMegaBytes = static_cast<size_t>(std::pow(2, std::floor(log2(sizeInMegaBytes))));
+    }
+
+    detach();
+    mPrivateMemory.reset();
+
+    const auto tableSize = ((sizeInMegaBytes * 1024 * 1024) / sizeof(Bucket));
+    std::unique_ptr<SharedMemory> sharedMemory(new SharedMemory(name, sizeof(SharedHeader) + tableSize * sizeof(Bucket)));
+    if (!sharedMemory->isOpen())
+    {
+        setSize(sizeInMegaBytes);
+        return false;
+    }
+
+    auto header = reinterpret_cast<SharedHeader*>(sharedMemory->data());
+    if (sharedMemory->isCreator())
+    {
+        // The memory is zeroed on creation, which is exactly what an empty table looks like.
+        header->mVersionHash = versionHash();
+        header->mBucketCount = tableSize;
+        header->mAttached.store(0);
+        header->mGeneration.store(1);
+        header->mReady.store(1);
+    }
+    else
+    {
+        for (auto i = 0; i < 1000 && !header->mReady.load(); ++i)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    // Whoever created the segment decided its size, the rest of us just use it. This keeps the total memory used fixed.
+    if (!header->mReady.load() || header->mVersionHash != versionHash() || header->mBucketCount == 0
+        || Bitboards::moreThanOneBitSet(header->mBucketCount)
+        || sharedMemory->size() < sizeof(SharedHeader) + header->mBucketCount * sizeof(Bucket))
+    {
+        setSize(sizeInMegaBytes);
+        return false;
+    }
+
+    ++header->mAttached;
+    mTable = reinterpret_cast<Bucket*>(sharedMemory->data() + sizeof(SharedHeader));
+    mTableSize = static_cast<size_t>(header->mBucketCount);
+    mSharedMemory = std::move(sharedMemory);
+    // Join the search generation of the processes already using the table instead of starting over.
+    mGeneration = static_cast<uint8_t>(header->mGeneration.load());
+    mReplacements.fill(0);
+    return true;
+}
+
+void TranspositionTable::allocate(size_t bucketCount)
+{
+    // Free the old table first, two big tables might not fit in memory at the same time.
+    mPrivateMemory.reset();
+    mPrivateMemory.reset(new char[bucketCount * sizeof(Bucket) + sizeof(Bucket) - 1]);
+
+    // Otherwise every bucket would straddle two cachelines and a probe could take two cache misses.
+    const auto address = reinterpret_cast<uintptr_t>(mPrivateMemory.get());
+    mTable = reinterpret_cast<Bucket*>((address + sizeof(Bucket) - 1) & ~static_cast<uintptr_t>(sizeof(Bucket) - 1));
+    mTableSize = bucketCount;
+    std::uninitialized_fill_n(mTable, mTableSize, Bucket());
+}
+
+void TranspositionTable::detach()
+{
+    if (!mSharedMemory)
+    {
+        return;
+    }
+
+    // The last process to detach removes the segment. A process which crashed while attached keeps it alive until the machine restarts.
+    auto header = reinterpret_cast<SharedHeader*>(mSharedMemory->data());
+    if (--header->mAttached == 0)
+    {
+        mSharedMemory->unlink();
+    }
+    mSharedMemory.reset();
+    mTable = nullptr;
+    mTableSize = 0;
+}
+
+void TranspositionTable::releaseShared()
+{
+    if (!mSharedMemory)
+    {
+        return;
+    }
+
+    auto header = reinterpret_cast<SharedHeader*>(mSharedMemory->data());
+    if (--header->mAttached == 0)
+    {
+        mSharedMemory->unlink();
+    }
+    // The mapping is leaked on purpose, it goes away when the process exits.
+    mSharedMemory.release();
 }
 
 void TranspositionTable::clear()
 {
-    const auto tableSize = mTable.size();
-    mTable.clear();
-    mTable.resize(tableSize);
+    // Other processes might still be using a shared table, so it is never cleared.
+    if (!mSharedMemory)
+    {
+        std::fill(mTable, mTable + mTableSize, Bucket());
+    }
     mGeneration = 1;
+    mReplacements.fill(0);
 }
 
 void TranspositionTable::prefetch(HashKey hk) const
 {
-    const auto* address = reinterpret_cast<const char*>(&mTable[hk & (mTable.size() - 1)]);
+    const auto* address = reinterpret_cast<const char*>(&mTable[hk & (mTableSize - 1)]);
 #if defined (_MSC_VER) || defined(__INTEL_COMPILER)
     _mm_prefetch(address, _MM_HINT_T0);
 #else
@@ -59,20 +175,24 @@ void TranspositionTable::prefetch(HashKey hk) const
 #endif
 }
 
-void TranspositionTable::save(HashKey hk, const Move& move, int score, int depth, int flags)
+void TranspositionTable::save(HashKey hk, const Move& move, int score, int depth, int flags, int staticEval)
 {
+    const auto key = static_cast<uint16_t>(hk >> 48);
     auto best = move;
-    auto hashEntry = &mTable[hk & (mTable.size() - 1)][0];
+    auto hashEntry = &mTable[hk & (mTableSize - 1)].mEntries[0];
     auto replace = hashEntry;
+    auto sameKey = false;
+    const auto generation = currentGeneration();
 
     // Determine the least valuable entry to replace.
-    for (auto i = 0; i < 4; ++i, ++hashEntry)
+    for (auto i = 0; i < bucketSize; ++i, ++hashEntry)
     {
         // If there already is an entry for this hashkey, replace it immediately.
         // If that entry was any good we wouldn't have gotten here.
-        if ((hashEntry->getHash() ^ hashEntry->getData()) == hk)
+        if ((hashEntry->getKey() ^ hashEntry->getChecksum()) == key && hashEntry->getFlags() != Flags::Empty)
         {
             replace = hashEntry;
+            sameKey = true;
             if (best.empty())
             {
                 best = hashEntry->getBestMove();
@@ -81,38 +201,49 @@ void TranspositionTable::save(HashKey hk, const Move& move, int score, int depth
         }
 
         // First replace entries which are from an older search, if that doesn't work consider depth.
-        if ((hashEntry->getGeneration() == mGeneration)
-          - (replace->getGeneration() == mGeneration)
+        if ((hashEntry->getGeneration() == generation)
+          - (replace->getGeneration() == generation)
           - (hashEntry->getDepth() < replace->getDepth()) < 0)
         {
             replace = hashEntry;
         }
     }
 
-    replace->setData((static_cast<uint64_t>(best.getRawMove()) | 
-                      static_cast<uint64_t>(mGeneration) << 16 | 
-                      static_cast<uint64_t>(score & 0xffff) << 32 | 
-                      static_cast<uint64_t>(depth & 0xff) << 48) | 
-                      static_cast<uint64_t>(flags) << 56);
+    if (SearchStatistics::enabled)
+    {
+        ++mReplacements[replace->getFlags() == Flags::Empty ? ReplacedEmpty
+                      : sameKey ? ReplacedSameKey
+                      : replace->getGeneration() != generation ? ReplacedOlderGeneration
+                      : replace->getDepth() <= depth ? ReplacedShallower
+                      : ReplacedDeeper];
+    }
+
+    replace->setData(best, score, staticEval, depth, generation, flags);
     // Use Dr. Hyatt's lockless hashing to make sure that there are no corrupted TT entries which remain undetected.
     // Not really necessary until we have multithreading.
-    replace->setHash(hk ^ replace->getData());
+    replace->setKey(key ^ replace->getChecksum());
 
-    // In multithreaded mode these could potetially fail. Think about that someday, even though we don't HAVE multithreading yet.
-    assert(replace->getBestMove() == best);
-    assert(replace->getGeneration() == mGeneration);
-    assert(replace->getScore() == score);
-    assert(replace->getDepth() == depth);
-    assert(replace->getFlags() == flags);
+    // Another process can write to the same entry in between with a shared table, so the entry can only be checked when it is private.
+    if (!mSharedMemory)
+    {
+        assert(replace->getBestMove() == best);
+        assert(replace->getGeneration() == generation);
+        assert(replace->getScore() == score);
+        assert(replace->getStaticEval() == staticEval);
+        assert(replace->getDepth() == depth);
+        assert(replace->getFlags() == flags);
+    }
 }
 
 const TranspositionTable::TranspositionTableEntry* TranspositionTable::probe(HashKey hk) const
 {
-    const auto* hashEntry = &mTable[hk & (mTable.size() - 1)][0];
+    const auto key = static_cast<uint16_t>(hk >> 48);
+    const auto* hashEntry = &mTable[hk & (mTableSize - 1)].mEntries[0];
 
-    for (auto i = 0; i < 4; ++i, ++hashEntry)
+    for (auto i = 0; i < bucketSize; ++i, ++hashEntry)
     {
-        if ((hashEntry->getHash() ^ hashEntry->getData()) == hk)
+        // Empty entries have all of their data set to zero, so they would match any hash key with the upper 16 bits set to zero.
+        if ((hashEntry->getKey() ^ hashEntry->getChecksum()) == key && hashEntry->getFlags() != Flags::Empty)
         {
             return hashEntry;
         }
@@ -123,8 +254,128 @@ const TranspositionTable::TranspositionTableEntry* TranspositionTable::probe(Has
 
 void TranspositionTable::startNewSearch() noexcept
 { 
-    ++mGeneration; 
+    // Only 6 bits are available for the generation in an entry. Zero is skipped as that is the generation of empty entries.
+    if (!mSharedMemory)
+    {
+        mGeneration = (mGeneration % 63) + 1;
+    }
+    else
+    {
+        // Several processes can start a search at the same time, each of them must advance the generation exactly once.
+        auto& sharedGeneration = reinterpret_cast<SharedHeader*>(mSharedMemory->data())->mGeneration;
+        auto generation = sharedGeneration.load();
+        while (!sharedGeneration.compare_exchange_weak(generation, (generation % 63) + 1))
+        {
+        }
+        mGeneration = static_cast<uint8_t>((generation % 63) + 1);
+    }
+    mReplacements.fill(0);
+}
+
+int TranspositionTable::hashFull() const
+{
+    // The first 167 buckets contain 1002 entries, close enough to a thousand for a permill value.
+    const auto bucketsToSample = std::min(mTableSize, static_cast<size_t>(167));
+    const auto generation = currentGeneration();
+    auto entries = 0, used = 0;
+
+    for (size_t i = 0; i < bucketsToSample; ++i)
+    {
+        for (auto& entry : mTable[i].mEntries)
+        {
+            used += (entry.getFlags() != Flags::Empty && entry.getGeneration() == generation);
+            ++entries;
+        }
+    }
+
+    return (entries ? (used * 1000) / entries : 0);
+}
+
+HashKey TranspositionTable::versionHash()
+{
+    // Bump this whenever the meaning of the data in the entries changes without changing their size.
+    const auto formatVersion = 1;
+    auto hash = static_cast<HashKey>(formatVersion) << 32 | sizeof(Bucket) << 16 | sizeof(TranspositionTableEntry);
+
+    // XORing the keys together would let changes cancel out, so multiply in between.
+    const auto mix = [&hash](HashKey key) { hash = (hash ^ key) * 0x9E3779B97F4A7C15; };
+    for (Piece p = Piece::WhitePawn; p <= Piece::BlackKing; ++p)
+    {
+        for (Square sq = Square::A1; sq <= Square::H8; ++sq)
+        {
+            mix(Zobrist::pieceHashKey(p, sq));
+        }
+    }
+    for (auto cr = 0; cr < 16; ++cr)
+    {
+        mix(Zobrist::castlingRightsHashKey(cr));
+    }
+    mix(Zobrist::turnHashKey());
+
+    return hash;
 }
 
+bool TranspositionTable::save(std::ostream& out) const
+{
+    FileHeader header = {};
+    std::copy_n("HAKKATT", header.mMagic.size(), header.mMagic.begin());
+    header.mVersionHash = versionHash();
+    header.mBucketCount = mTableSize;
+    header.mGeneration = currentGeneration();
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
 
+    // Write in chunks to keep the amount of bytes representable in a std::streamsize on every platform.
+    const auto chunkSize = static_cast<size_t>(1) << 20;
+    for (size_t i = 0; i < mTableSize && out; i += chunkSize)
+    {
+        const auto buckets = std::min(chunkSize, mTableSize - i);
+        out.write(reinterpret_cast<const char*>(&mTable[i]), static_cast<std::streamsize>(buckets * sizeof(Bucket)));
+    }
+
+    return static_cast<bool>(out);
+}
 
+bool TranspositionTable::load(std::istream& in)
+{
+    FileHeader header;
+    in.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!in || !std::equal(header.mMagic.begin(), header.mMagic.end(), "HAKKATT") || header.mVersionHash != versionHash()
+        || header.mBucketCount == 0 || Bitboards::moreThanOneBitSet(header.mBucketCount))
+    {
+        // Nothing has been overwritten yet, keep the analysis the table already has.
+        return false;
+    }
+
+    // No need to clear the table first if the size stays the same, everything is overwritten anyway.
+    // The size of a shared table can't be changed under the other processes.
+    if (mTableSize != header.mBucketCount)
+    {
+        if (mSharedMemory)
+        {
+            return false;
+        }
+        allocate(static_cast<size_t>(header.mBucketCount));
+    }
+
+    const auto chunkSize = static_cast<size_t>(1) << 20;
+    for (size_t i = 0; i < mTableSize && in; i += chunkSize)
+    {
+        const auto buckets = std::min(chunkSize, mTableSize - i);
+        in.read(reinterpret_cast<char*>(&mTable[i]), static_cast<std::streamsize>(buckets * sizeof(Bucket)));
+    }
+
+    // A part of the table has already been overwritten, the rest doesn't match it anymore.
+    if (!in)
+    {
+        clear();
+        return false;
+    }
+
+    mGeneration = header.mGeneration;
+    if (mSharedMemory)
+    {
+        reinterpret_cast<SharedHeader*>(mSharedMemory->data())->mGeneration.store(mGeneration);
+    }
+    mReplacements.fill(0);
+    return true;
+}
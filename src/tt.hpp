@@ -23,13 +23,20 @@
 
 #include <cstdint>
 #include <array>
-#include <vector>
+#include <atomic>
+#include <iosfwd>
+#include <memory>
+#include <string>
 #include "move.hpp"
 #include "zobrist.hpp"
+#include "search_statistics.hpp"
+#include "utils/shared_memory.hpp"
 
 /// @brief Transposition table used for storing previous results of the search function.
 ///
 /// Default size of the transposition table is 32MB.
+/// The table can also be placed in a named block of shared memory, letting several engine processes on the same machine share one table.
+/// That is safe without any locking thanks to the lockless hashing used for validating the entries.
 class TranspositionTable
 {
 public:
@@ -43,93 +50,127 @@ public:
         Empty = 0, ExactScore = 1, UpperBoundScore = 2, LowerBoundScore = 3
     };
 
+    /// @brief The reasons for which save can overwrite an entry.
+    /// SameKey means that the entry was for the same position.
+    /// OlderGeneration means that the entry was from an older search.
+    /// Shallower means that the entry was from the current search and had at most the depth of the new entry.
+    /// Deeper means that the entry was from the current search and had a larger depth than the new entry.
+    enum Replacement
+    {
+        ReplacedEmpty = 0, ReplacedSameKey = 1, ReplacedOlderGeneration = 2, ReplacedShallower = 3, ReplacedDeeper = 4, NumberOfReplacements = 5
+    };
+
     /// @brief A single entry in the transposition table.
     ///
-    /// Contains the best move, score, generation, depth and flags for a single position encountered in the search.
+    /// Contains the best move, score, static evaluation, generation, depth and flags for a single position encountered in the search.
+    /// Only the upper 16 bits of the hash key are stored, the lower bits are implied by the bucket the entry is in.
     class TranspositionTableEntry
     {
     public:
         /// @brief Default constructor.
-        TranspositionTableEntry() noexcept : mHash(0), mData(0) 
+        TranspositionTableEntry() noexcept : mKey(0), mBestMove(0), mScore(0), mStaticEval(0), mDepth(0), mGenerationAndFlags(0)
         {
         }
 
-        /// @brief Set the hash key of this TT entry.
-        void setHash(uint64_t newHash) noexcept 
+        /// @brief Set the key of this TT entry. The key should be XORed with the checksum of the data.
+        void setKey(uint16_t newKey) noexcept 
         { 
-            mHash = newHash; 
+            mKey = newKey; 
         }
 
-        /// @brief Set the data of this TT entry. This data should be in a packed format.
-        void setData(uint64_t newData) noexcept 
+        /// @brief Set the data of this TT entry.
+        void setData(const Move& bestMove, int score, int staticEval, int depth, uint8_t generation, int flags) noexcept 
         {
-            mData = newData; 
+            mBestMove = bestMove.getRawMove();
+            mScore = static_cast<int16_t>(score);
+            mStaticEval = static_cast<int16_t>(staticEval);
+            mDepth = static_cast<int8_t>(depth);
+            mGenerationAndFlags = static_cast<uint8_t>(generation << 2 | flags);
         }
 
-        /// @brief Get the hash key of this TT entry.
-        /// @return The hash key.
-        uint64_t getHash() const noexcept 
+        /// @brief Get the key of this TT entry.
+        /// @return The key.
+        uint16_t getKey() const noexcept 
         {
-            return mHash; 
+            return mKey; 
         }
 
-        /// @brief Get the packed data of this TT entry. Not really used as is except for validation of TT entry integrity.
-        /// @return The packed data.
-        uint64_t getData() const noexcept 
+        /// @brief Get a checksum of the data of this TT entry. Used for validation of TT entry integrity.
+        /// @return The checksum.
+        uint16_t getChecksum() const noexcept 
         { 
-            return mData; 
+            return mBestMove ^ static_cast<uint16_t>(mScore) ^ static_cast<uint16_t>(mStaticEval) 
+                 ^ static_cast<uint16_t>(static_cast<uint8_t>(mDepth) | mGenerationAndFlags << 8); 
         }
 
         /// @brief Get the saved best move of this TT entry.
         /// @return The best move. Note that ALL-nodes have no best move.
         Move getBestMove() const noexcept 
         { 
-            return static_cast<uint16_t>(mData); 
+            return mBestMove; 
         }
 
         /// @brief Get the generation of this TT entry. Used for TT replacement policy.
         /// @return The generation.
-        uint16_t getGeneration() const noexcept 
+        uint8_t getGeneration() const noexcept 
         { 
-            return static_cast<uint16_t>(mData >> 16); 
+            return mGenerationAndFlags >> 2; 
         }
 
         /// @brief Get the score of this TT entry.
         /// @return The score. Mate scores need to be adjusted.
         int16_t getScore() const noexcept 
         { 
-            return static_cast<int16_t>(mData >> 32); 
+            return mScore; 
+        }
+
+        /// @brief Get the static evaluation of the position of this TT entry.
+        /// @return The static evaluation, -infinity if it is not known.
+        int16_t getStaticEval() const noexcept 
+        { 
+            return mStaticEval; 
         }
 
         /// @brief Get the depth of this TT entry.
         /// @return The depth.
         int8_t getDepth() const noexcept 
         { 
-            return static_cast<int8_t>(mData >> 48);
+            return mDepth;
         }
 
         /// @brief Get the flags of this TT entry. 
         /// @return The flags. 
         uint8_t getFlags() const noexcept 
         {
-            return mData >> 56; 
+            return mGenerationAndFlags & 3; 
         };
 
     private:
-        uint64_t mHash;
-        uint64_t mData; // 16 bits for the best move, 16 bits for the generation (only 4 or so are actually necessary), 16 bits for the score, 8 bits for the depth and 8 bits for the flags (only 2 bits necessary).
+        uint16_t mKey;
+        uint16_t mBestMove;
+        int16_t mScore;
+        int16_t mStaticEval;
+        int8_t mDepth;
+        uint8_t mGenerationAndFlags; // 6 bits for the generation and 2 bits for the flags.
     };
 
     /// @brief Default constructor.
     TranspositionTable();
 
+    /// @brief Destructor, detaches from a shared table.
+    ~TranspositionTable();
+
+    TranspositionTable(const TranspositionTable&) = delete;
+    TranspositionTable& operator=(const TranspositionTable&) = delete;
+
     /// @brief Save some information to the transposition table.
     /// @param hk The hash key for the position the information is for.
     /// @param move The best move in the position. Note that ALL-nodes have no best move by definition.
     /// @param score The score of the position.
     /// @param depth The depth the position was searched to.
     /// @param flags Flags indicating whether the position is a PV, CUT, or an ALL node.
-    void save(HashKey hk, const Move& move, int score, int depth, int flags);
+    /// @param staticEval The static evaluation of the position, -infinity if it is not known.
+    void save(HashKey hk, const Move& move, int score, int depth, int flags, int staticEval);
 
     /// @brief Get the transposition table entry for a given hash key.
     /// @param hk The hash key for the position we want the entry for.
@@ -140,24 +181,141 @@ public:
     /// @param hk The hash key for the part of the transposition table we want to load to the cache.
     void prefetch(HashKey hk) const;
 
-    /// @brief Sets the size of the transposition table.
+    /// @brief Sets the size of the transposition table. Detaches from a shared table.
     /// @param sizeInMegaBytes Obviously, the new size of the hash table in megabytes.
     void setSize(size_t sizeInMegaBytes);
 
-    /// @brief Clears the transposition table. Can potentially be an expensive operation.
+    /// @brief Attaches to a transposition table shared by several processes, creating it if no other process has done so yet.
+    /// @param name The name of the shared table.
+    /// @param sizeInMegaBytes The size of the table if it is created. If the table already exists it keeps the size it was created with.
+    /// @return True if succesful. If not, a private table of the given size is used instead.
+    ///
+    /// The shared table is removed when the last process attached to it detaches.
+    bool attach(const std::string& name, size_t sizeInMegaBytes);
+
+    /// @brief Gives up the claim of this process on a shared table without unmapping it, so that a search still running is not affected.
+    ///
+    /// Must be called before exiting without running destructors, otherwise the shared table outlives all processes using it.
+    void releaseShared();
+
+    /// @brief Checks if the transposition table is shared with other processes.
+    /// @return True if it is.
+    bool isShared() const noexcept;
+
+    /// @brief Clears the transposition table. Can potentially be an expensive operation. 
+    ///
+    /// A shared table is not cleared as other processes might still be using it.
     void clear();
 
+    /// @brief Writes the transposition table to a stream.
+    /// @param out The stream, must be opened in binary mode.
+    /// @return True if the whole table was written succesfully.
+    ///
+    /// The table is written as a 64-byte header followed by the buckets exactly as they are in memory, so a saved table can also be mapped into memory as is.
+    bool save(std::ostream& out) const;
+
+    /// @brief Reads a transposition table written by save from a stream. The table is resized to the size of the saved one.
+    /// @param in The stream, must be opened in binary mode.
+    /// @return True if succesful. False if the stream does not contain a table saved by a compatible version of the program or the size of a shared table would change, in that case the table is left untouched. Also false if the stream ends in the middle of the table, in that case the table is cleared.
+    bool load(std::istream& in);
+
+    /// @brief Get the size of the transposition table.
+    /// @return The size in megabytes.
+    size_t getSize() const;
+
     /// @brief Used for notifying the TT that we are starting a new search. That information is used in the replacement policy.
     void startNewSearch() noexcept;
 
+    /// @brief Estimates how full the transposition table is by looking at the first few buckets.
+    /// @return The amount of entries from the current search, in permill.
+    int hashFull() const;
+
+    /// @brief Get the amount of entries overwritten for a given reason during the current search. Only counted if search statistics are enabled.
+    /// @param reason The reason.
+    /// @return The amount of entries overwritten.
+    uint64_t getReplacements(Replacement reason) const;
+
 private:
-    // Notice how we have a bucket containing four hash entries.
+    // Notice how we have a bucket containing six hash entries.
     // Doing this has some desirable properties when deciding what entries to overwrite.
-    // Also, we have four entries because the common cache line size nowadays is 64 bytes.
-    // uint64_t hash * 4 + uint64_t data * 4 = 8 * uint64_t = 64 bytes.
+    // An entry takes 10 bytes so six of them fit into a 64-byte cacheline with 4 bytes left over.
     // Basically this means that a single cluster fits perfectly into the cacheline.
-    std::vector<std::array<TranspositionTableEntry, 4>> mTable;
-    uint16_t mGeneration;
+    static const int bucketSize = 6;
+    struct Bucket
+    {
+        std::array<TranspositionTableEntry, bucketSize> mEntries;
+        std::array<uint8_t, 4> mPadding;
+    };
+    static_assert(sizeof(Bucket) == 64, "A bucket must fill a cacheline exactly.");
+
+    // The header of a saved table. Takes a whole cacheline so that the buckets following it stay aligned when the file is mapped into memory.
+    struct FileHeader
+    {
+        std::array<char, 8> mMagic;
+        HashKey mVersionHash;
+        uint64_t mBucketCount;
+        uint8_t mGeneration;
+        std::array<uint8_t, 39> mPadding;
+    };
+    static_assert(sizeof(FileHeader) == 64, "The header of a saved table must fill a cacheline exactly.");
+
+    // The header of a shared table, in front of the buckets. The creator sets everything before setting the ready flag.
+    struct SharedHeader
+    {
+        std::atomic<uint32_t> mReady;
+        std::atomic<uint32_t> mAttached;
+        HashKey mVersionHash;
+        uint64_t mBucketCount;
+        // The generation of the latest search of any attached process. Each process keeping its own would make the entries of the others look stale.
+        std::atomic<uint32_t> mGeneration;
+        std::array<uint8_t, 36> mPadding;
+    };
+    static_assert(sizeof(SharedHeader) == 64, "The header of a shared table must fill a cacheline exactly.");
+
+    // Identifies the layout of the entries and the zobrist keys. A table saved by a version of the program where either differs is useless.
+    static HashKey versionHash();
+
+    void detach();
+
+    // The generation of the current search. While attached it is shared by all processes using the table.
+    uint8_t currentGeneration() const noexcept;
+
+    // Allocates a private table of a given amount of empty buckets, aligned to a cacheline.
+    void allocate(size_t bucketCount);
+
+    // Points either to the private table or to the buckets in the shared memory.
+    Bucket* mTable;
+    size_t mTableSize;
+    // The memory of the private table. It is a bit larger than the table, new only guarantees the alignment of the largest built-in type.
+    std::unique_ptr<char[]> mPrivateMemory;
+    std::unique_ptr<SharedMemory> mSharedMemory;
+    uint8_t mGeneration;
+    std::array<uint64_t, NumberOfReplacements> mReplacements;
 };
 
+inline size_t TranspositionTable::getSize() const
+{
+    return (mTableSize * sizeof(Bucket)) / (1024 * 1024);
+}
+
+inline bool TranspositionTable::isShared() const noexcept
+{
+    return mSharedMemory != nullptr;
+}
+
+inline uint8_t TranspositionTable::currentGeneration() const noexcept
+{
+    if (!mSharedMemory)
+    {
+        return mGeneration;
+    }
+    const auto header = reinterpret_cast<const SharedHeader*>(mSharedMemory->data());
+    return static_cast<uint8_t>(header->mGeneration.load(std::memory_order_relaxed));
+}
+
+inline uint64_t TranspositionTable::getReplacements(Replacement reason) const
+{
+    return mReplacements[reason];
+}
+
 #endif
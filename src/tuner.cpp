@@ -0,0 +1,161 @@
+/*
+    Hakkapeliitta - A UCI chess engine. Copyright (C) 2013-2015 Mikko Aarnos.
+
+    Hakkapeliitta is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Hakkapeliitta is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Hakkapeliitta. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "tuner.hpp"
+#include <algorithm>
+#include <cmath>
+
+// The parameters are perturbed this much when estimating the gradient.
+const double perturbation = 1.0;
+
+// The decay rates and the epsilon of Adam.
+const double firstMomentDecay = 0.9;
+const double secondMomentDecay = 0.999;
+const double adamEpsilon = 1e-8;
+
+Tuner::Tuner(const std::string& fileName, int threads) :
+    mFile(fileName), mPositions(reinterpret_cast<const PackedPosition*>(mFile.data())),
+    mSize(mFile.size() / sizeof(PackedPosition)), mScalingConstant(1.0), mEvaluations(threads), mThreadPool(threads - 1), mSteps(0), mRng(std::random_device{}())
+{
+    for (auto& group : Evaluation::getParameterGroups())
+    {
+        for (auto value : group.mValues)
+        {
+            mParameters.push_back(value);
+            mValues.push_back(*value);
+        }
+    }
+    mFirstMoments.assign(mParameters.size(), 0.0);
+    mSecondMoments.assign(mParameters.size(), 0.0);
+}
+
+void Tuner::setParameters(const std::vector<double>& values)
+{
+    for (size_t i = 0; i < mParameters.size(); ++i)
+    {
+        *mParameters[i] = static_cast<int>(std::lround(values[i]));
+    }
+    Evaluation::staticInitialize();
+}
+
+double Tuner::error(size_t begin, size_t end)
+{
+    const auto threads = mEvaluations.size();
+    std::vector<double> errors(threads, 0.0);
+
+    // The calling thread does its share as well, that is why the pool has one thread less.
+    mThreadPool.parallelFor(0, threads, [&](size_t t)
+    {
+        auto& evaluation = mEvaluations[t];
+        // The cached pawn structure scores were calculated with different parameters.
+        evaluation.clearPawnHashTable();
+        auto sum = 0.0;
+        for (auto i = begin + t; i < end; i += threads)
+        {
+            const auto& packedPosition = mPositions[i];
+            const auto score = evaluation.evaluate(packedPosition.getPosition());
+            const auto expected = 1.0 / (1.0 + std::pow(10.0, -mScalingConstant * score / 400.0));
+            const auto result = (packedPosition.getResult() + 1) / 2.0;
+            sum += (result - expected) * (result - expected);
+        }
+        errors[t] = sum;
+    });
+
+    auto sum = 0.0;
+    for (auto e : errors)
+    {
+        sum += e;
+    }
+    return (end > begin ? sum / (end - begin) : 0.0);
+}
+
+double Tuner::error()
+{
+    setParameters(mValues);
+    return error(0, mSize);
+}
+
+double Tuner::computeScalingConstant()
+{
+    // The error is unimodal in the scaling constant, so golden section search works.
+    const auto end = std::min(mSize, static_cast<size_t>(1000000));
+    const auto ratio = (std::sqrt(5.0) - 1.0) / 2.0;
+    auto low = 0.0, high = 3.0;
+
+    setParameters(mValues);
+    while (high - low > 0.001)
+    {
+        const auto a = high - ratio * (high - low);
+        const auto b = low + ratio * (high - low);
+        mScalingConstant = a;
+        const auto errorA = error(0, end);
+        mScalingConstant = b;
+        const auto errorB = error(0, end);
+        (errorA < errorB ? high : low) = (errorA < errorB ? b : a);
+    }
+
+    mScalingConstant = (low + high) / 2.0;
+    return mScalingConstant;
+}
+
+void Tuner::runEpoch(size_t batchSize, double learningRate)
+{
+    batchSize = std::max(batchSize, static_cast<size_t>(1));
+    const auto batches = (mSize + batchSize - 1) / batchSize;
+    std::vector<size_t> order(batches);
+    for (size_t i = 0; i < batches; ++i)
+    {
+        order[i] = i;
+    }
+    std::shuffle(order.begin(), order.end(), mRng);
+
+    std::vector<double> perturbations(mParameters.size()), values(mParameters.size());
+    std::bernoulli_distribution coinFlip;
+    for (auto batch : order)
+    {
+        const auto begin = batch * batchSize;
+        const auto end = std::min(begin + batchSize, mSize);
+
+        for (size_t i = 0; i < mParameters.size(); ++i)
+        {
+            perturbations[i] = (coinFlip(mRng) ? perturbation : -perturbation);
+            values[i] = mValues[i] + perturbations[i];
+        }
+        setParameters(values);
+        const auto errorPlus = error(begin, end);
+
+        for (size_t i = 0; i < mParameters.size(); ++i)
+        {
+            values[i] = mValues[i] - perturbations[i];
+        }
+        setParameters(values);
+        const auto errorMinus = error(begin, end);
+
+        ++mSteps;
+        const auto firstCorrection = 1.0 - std::pow(firstMomentDecay, mSteps);
+        const auto secondCorrection = 1.0 - std::pow(secondMomentDecay, mSteps);
+        for (size_t i = 0; i < mParameters.size(); ++i)
+        {
+            const auto gradient = (errorPlus - errorMinus) / (2.0 * perturbations[i]);
+            mFirstMoments[i] = firstMomentDecay * mFirstMoments[i] + (1.0 - firstMomentDecay) * gradient;
+            mSecondMoments[i] = secondMomentDecay * mSecondMoments[i] + (1.0 - secondMomentDecay) * gradient * gradient;
+            mValues[i] -= learningRate * (mFirstMoments[i] / firstCorrection) / (std::sqrt(mSecondMoments[i] / secondCorrection) + adamEpsilon);
+        }
+    }
+
+    setParameters(mValues);
+}
@@ -0,0 +1,103 @@
+/*
+    Hakkapeliitta - A UCI chess engine. Copyright (C) 2013-2015 Mikko Aarnos.
+
+    Hakkapeliitta is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Hakkapeliitta is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Hakkapeliitta. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/// @file tuner.hpp
+/// @author Mikko Aarnos
+
+#ifndef TUNER_HPP_
+#define TUNER_HPP_
+
+#include <random>
+#include <string>
+#include <vector>
+#include "evaluation.hpp"
+#include "packed_position.hpp"
+#include "utils/mapped_file.hpp"
+#include "utils/threadpool.hpp"
+
+/// @brief Tunes the parameters of the evaluation function with the Texel tuning method.
+///
+/// The error being minimized is the mean squared difference between the game results and the evaluations of the positions mapped to expected results with a sigmoid.
+/// The positions are read from a memory-mapped file of PackedPositions, which should only contain quiet positions as we call the evaluation function directly.
+///
+/// The gradient is estimated with simultaneous perturbation (SPSA): all parameters are moved randomly up or down at the same time and the error is calculated on both sides.
+/// This needs only two evaluations of each position per step regardless of the amount of parameters, unlike finite differences which need two per parameter.
+/// The parameters are then updated with Adam.
+class Tuner
+{
+public:
+    /// @brief Constructs a new tuner.
+    /// @param fileName The file containing the positions.
+    /// @param threads The amount of threads used for evaluating the positions.
+    Tuner(const std::string& fileName, int threads);
+
+    /// @brief Checks if the file of positions was opened succesfully.
+    /// @return True if it was.
+    bool isOpen() const;
+
+    /// @brief Get the amount of positions.
+    /// @return The amount of positions.
+    size_t size() const;
+
+    /// @brief Finds the scaling constant of the sigmoid which minimizes the error with the current parameters.
+    /// @return The scaling constant.
+    ///
+    /// Must be called before running any epochs. Uses at most the first million positions.
+    double computeScalingConstant();
+
+    /// @brief Calculates the error over all positions with the current parameters.
+    /// @return The error.
+    double error();
+
+    /// @brief Goes through all positions once in batches of a given size, updating the parameters after each batch.
+    /// @param batchSize The amount of positions in a batch.
+    /// @param learningRate The learning rate of Adam. Roughly the maximum change of a parameter per batch.
+    void runEpoch(size_t batchSize, double learningRate);
+
+private:
+    MappedFile mFile;
+    const PackedPosition* mPositions;
+    size_t mSize;
+    double mScalingConstant;
+
+    std::vector<Evaluation> mEvaluations;
+    ThreadPool mThreadPool;
+    std::vector<int*> mParameters;
+    std::vector<double> mValues;
+    std::vector<double> mFirstMoments;
+    std::vector<double> mSecondMoments;
+    int mSteps;
+    std::mt19937 mRng;
+
+    // Sets the parameters of the evaluation function to the given values rounded to the nearest integers.
+    void setParameters(const std::vector<double>& values);
+
+    // Calculates the error over the positions from begin to end, using all threads.
+    double error(size_t begin, size_t end);
+};
+
+inline bool Tuner::isOpen() const
+{
+    return mFile.isOpen();
+}
+
+inline size_t Tuner::size() const
+{
+    return mSize;
+}
+
+#endif
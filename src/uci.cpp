@@ -16,17 +16,21 @@
 */
 
 #include "uci.hpp"
+#include <cctype>
 #include <iostream>
 #include "utils/clamp.hpp"
 #include "benchmark.hpp"
+#include "coordinator.hpp"
 #include "search_parameters.hpp"
+#include "selfplay.hpp"
 #include "textio.hpp"
+#include "tuner.hpp"
 #include "syzygy/tbprobe.hpp"
 
 UCI::UCI() :
 search(*this), sync_cout(std::cout), ponder(true),
 contempt(0), pawnHashTableSize(4), transpositionTableSize(32), syzygyProbeDepth(1), 
-syzygyProbeLimit(6), syzygy50MoveRule(true), rootPly(0)
+syzygyProbeLimit(6), syzygy50MoveRule(true), ownBook(false), multiPv(1), positionCommand("position startpos"), rootPly(0)
 {
     addCommand("uci", &UCI::sendInformation);
     addCommand("isready", &UCI::isReady);
@@ -39,6 +43,14 @@ syzygyProbeLimit(6), syzygy50MoveRule(true), rootPly(0)
     addCommand("ponderhit", &UCI::ponderhit);
     addCommand("displayboard", &UCI::displayBoard);
     addCommand("perft", &UCI::perft);
+    addCommand("stats", &UCI::stats);
+    addCommand("analyse", &UCI::analyse);
+    addCommand("testsuite", &UCI::testSuite);
+    addCommand("gensfen", &UCI::generatePositions);
+    addCommand("tune", &UCI::tune);
+    addCommand("savehash", &UCI::saveHash);
+    addCommand("loadhash", &UCI::loadHash);
+    addCommand("split", &UCI::split);
 
     repetitionHashKeys.assign(1024, 0);
 }
@@ -100,12 +112,16 @@ void UCI::sendInformation(Position&, std::istringstream&)
     sync_cout << "option name Hash type spin default 32 min 1 max 65536" << std::endl;
     sync_cout << "option name Pawn Hash type spin default 4 min 1 max 8192" << std::endl;
     sync_cout << "option name Clear Hash type button" << std::endl;
+    sync_cout << "option name SharedHash type string default <empty>" << std::endl;
     sync_cout << "option name Contempt type spin default 0 min -75 max 75" << std::endl;
     sync_cout << "option name Ponder type check default true" << std::endl;
     sync_cout << "option name SyzygyPath type string default <empty>" << std::endl;
     sync_cout << "option name SyzygyProbeDepth type spin default 1 min 1 max 100" << std::endl;
     sync_cout << "option name SyzygyProbeLimit type spin default 6 min 0 max 6" << std::endl;
     sync_cout << "option name Syzygy50MoveRule type check default true" << std::endl;
+    sync_cout << "option name OwnBook type check default false" << std::endl;
+    sync_cout << "option name BookFile type string default <empty>" << std::endl;
+    sync_cout << "option name MultiPV type spin default 1 min 1 max 256" << std::endl;
 
     // Send a response telling the listener that we are ready in UCI-mode.
     sync_cout << "uciok" << std::endl;
@@ -126,6 +142,7 @@ void UCI::quit(Position&, std::istringstream&)
 {
     search.stopPondering();
     search.stopSearching();
+    search.releaseSharedTranspositionTable();
     // TODO: it might be cleaner to just exit the mainLoop somehow instead of this.
     exit(0);
 }
@@ -151,7 +168,7 @@ void UCI::setOption(Position&, std::istringstream& iss)
     else if (name == "Hash")
     {
         iss >> transpositionTableSize;
-        search.setTranspositionTableSize(transpositionTableSize);
+        setTranspositionTable();
     }
     else if (name == "Pawn Hash")
     {
@@ -189,12 +206,66 @@ void UCI::setOption(Position&, std::istringstream& iss)
     {
         iss >> std::boolalpha >> syzygy50MoveRule;
     }
+    else if (name == "SharedHash")
+    {
+        sharedHashName.clear();
+        while (iss >> s)
+        {
+            sharedHashName += std::string(" ", !sharedHashName.empty()) + s;
+        }
+        if (sharedHashName == "<empty>")
+        {
+            sharedHashName.clear();
+        }
+        setTranspositionTable();
+    }
+    else if (name == "MultiPV")
+    {
+        iss >> multiPv;
+        multiPv = clamp(multiPv, 1, 256);
+    }
+    else if (name == "OwnBook")
+    {
+        iss >> std::boolalpha >> ownBook;
+    }
+    else if (name == "BookFile")
+    {
+        std::string path;
+        while (iss >> s)
+        {
+            path += std::string(" ", !path.empty()) + s;
+        }
+        if (path.empty() || path == "<empty>")
+        {
+            book.close();
+        }
+        else if (!book.open(path))
+        {
+            sync_cout << "info string could not open the book file" << std::endl;
+        }
+    }
     else
     {
         sync_cout << "info string no such option exists" << std::endl;
     }
 }
 
+void UCI::setTranspositionTable()
+{
+    if (sharedHashName.empty())
+    {
+        search.setTranspositionTableSize(transpositionTableSize);
+    }
+    else if (search.setSharedTranspositionTable(sharedHashName, transpositionTableSize))
+    {
+        sync_cout << "info string using shared hash " << sharedHashName << " of size " << search.getTranspositionTableSize() << std::endl;
+    }
+    else
+    {
+        sync_cout << "info string could not use shared hash " << sharedHashName << std::endl;
+    }
+}
+
 void UCI::newGame(Position&, std::istringstream&)
 {
     search.clearSearch();
@@ -204,11 +275,20 @@ void UCI::go(Position& pos, std::istringstream& iss)
 {
     SearchParameters searchParameters;
     std::string s;
+    auto readingSearchMoves = false;
 
     // Parse the string to get the parameters for the search.
     while (iss >> s)
     {
-        if (s == "searchmoves") {} // TODO: implement this
+        // The moves after "searchmoves" continue until the next keyword.
+        if (readingSearchMoves && s.size() >= 4 && s.size() <= 5 && std::isdigit(s[1]) && std::isdigit(s[3]))
+        {
+            searchParameters.mSearchMoves.push_back(uciFormatToMove(pos, s));
+            continue;
+        }
+        readingSearchMoves = false;
+
+        if (s == "searchmoves") { readingSearchMoves = true; }
         else if (s == "ponder") { searchParameters.mPonder = true; }
         else if (s == "wtime") { iss >> searchParameters.mTime[Color::White]; }
         else if (s == "btime") { iss >> searchParameters.mTime[Color::Black]; }
@@ -217,16 +297,28 @@ void UCI::go(Position& pos, std::istringstream& iss)
         else if (s == "movestogo") { iss >> searchParameters.mMovesToGo; searchParameters.mMovesToGo += 2; }
         else if (s == "depth") { iss >> searchParameters.mDepth; }
         else if (s == "nodes") { iss >> searchParameters.mNodes; }
-        else if (s == "mate") { searchParameters.mMate = true; }
+        else if (s == "mate") { iss >> searchParameters.mMate; }
         else if (s == "movetime") { iss >> searchParameters.mMoveTime; }
         else if (s == "infinite") { searchParameters.mInfinite = true; }
     }
 
+    // Answer instantly if the position is in the book. Pondering, analysis and restricted searches always search.
+    if (ownBook && !searchParameters.mPonder && !searchParameters.mInfinite && !searchParameters.mMate && searchParameters.mSearchMoves.empty())
+    {
+        const auto bookMove = book.getMove(pos);
+        if (!bookMove.empty())
+        {
+            sync_cout << "bestmove " << moveToUciFormat(bookMove) << std::endl;
+            return;
+        }
+    }
+
     searchParameters.mRootPly = rootPly;
     searchParameters.mHashKeys = repetitionHashKeys;
     searchParameters.mSyzygyProbeDepth = syzygyProbeDepth;
     searchParameters.mSyzygyProbeLimit = syzygyProbeLimit;
     searchParameters.mSyzygy50MoveRule = syzygy50MoveRule;
+    searchParameters.mMultiPv = multiPv;
 
     search.go(pos, searchParameters);
 }
@@ -235,6 +327,7 @@ void UCI::position(Position& pos, std::istringstream& iss)
 {
     std::string s, fen;
     rootPly = 0;
+    positionCommand = iss.str();
 
     iss >> s;
     
@@ -260,32 +353,8 @@ void UCI::position(Position& pos, std::istringstream& iss)
     // Parse the moves.
     while (iss >> s)
     {
-        Piece promotion = Piece::Empty;
-        const auto from = (s[0] - 'a') + 8 * (s[1] - '1');
-        const auto to = (s[2] - 'a') + 8 * (s[3] - '1');
-
-        if (s.size() == 5)
-        {
-            switch (s[4])
-            {
-                case 'q': promotion = Piece::Queen; break;
-                case 'r':promotion = Piece::Rook; break;
-                case 'b': promotion = Piece::Bishop; break;
-                case 'n': promotion = Piece::Knight; break;
-                default:;
-            }
-        }
-        else if (pos.getBoard(from).getPieceType() == Piece::King && std::abs(from - to) == 2)
-        {
-            promotion = Piece::King;
-        }
-        else if (pos.getBoard(from).getPieceType() == Piece::Pawn && to == pos.getEnPassantSquare())
-        {
-            promotion = Piece::Pawn;
-        }
-
         repetitionHashKeys[rootPly++] = pos.getHashKey();
-        pos.makeMove(Move(from, to, promotion));
+        pos.makeMove(uciFormatToMove(pos, s));
     }
 }
 
@@ -316,6 +385,117 @@ void UCI::perft(Position& pos, std::istringstream& iss)
     }
 }
 
+void UCI::stats(Position&, std::istringstream&)
+{
+    sync_cout << search.getStatistics() << std::flush;
+}
+
+void UCI::analyse(Position&, std::istringstream& iss)
+{
+    runAnalysis(iss, Analysis::Analyse, 1);
+}
+
+void UCI::testSuite(Position&, std::istringstream& iss)
+{
+    runAnalysis(iss, Analysis::TestSuite, std::max(1u, std::thread::hardware_concurrency()));
+}
+
+void UCI::runAnalysis(std::istringstream& iss, Analysis::Mode mode, int defaultThreads)
+{
+    SearchParameters searchParameters;
+    std::string inputFileName, outputFileName, s;
+    auto threads = defaultThreads;
+
+    iss >> inputFileName;
+    outputFileName = inputFileName + ".out";
+    while (iss >> s)
+    {
+        if (s == "depth") { iss >> searchParameters.mDepth; }
+        else if (s == "nodes") { iss >> searchParameters.mNodes; }
+        else if (s == "movetime") { iss >> searchParameters.mMoveTime; }
+        else if (s == "threads") { iss >> threads; }
+        else if (s == "output") { iss >> outputFileName; }
+    }
+
+    if (!searchParameters.mDepth && !searchParameters.mNodes && !searchParameters.mMoveTime)
+    {
+        sync_cout << "info string no depth, nodes or movetime given" << std::endl;
+        return;
+    }
+
+    Analysis analysis(inputFileName, outputFileName, mode);
+    if (!analysis.isOpen())
+    {
+        sync_cout << "info string could not open the files" << std::endl;
+        return;
+    }
+
+    searchParameters.mContempt = contempt;
+    searchParameters.mSyzygyProbeDepth = syzygyProbeDepth;
+    searchParameters.mSyzygyProbeLimit = syzygyProbeLimit;
+    searchParameters.mSyzygy50MoveRule = syzygy50MoveRule;
+
+    Stopwatch sw;
+    sw.start();
+    const auto positions = analysis.run(searchParameters, clamp(threads, 1, 256), transpositionTableSize, pawnHashTableSize);
+    sw.stop();
+    const auto time = sw.elapsed<std::chrono::milliseconds>();
+    sync_cout << "info string analysed " << positions << " positions"
+              << " time " << time
+              << " positions/s " << (positions * 1000) / (time + 1) << std::endl;
+    if (mode == Analysis::TestSuite)
+    {
+        sync_cout << "info string solved " << analysis.getSolvedCount() << " / " << analysis.getTestCount()
+                  << " average time to solution " << analysis.getAverageSolutionTime() << std::endl;
+    }
+}
+
+void UCI::generatePositions(Position&, std::istringstream& iss)
+{
+    SearchParameters searchParameters;
+    std::string outputFileName, s;
+    uint64_t positions = 1000000;
+    auto threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    auto randomPlies = 8;
+
+    iss >> outputFileName;
+    while (iss >> s)
+    {
+        if (s == "depth") { iss >> searchParameters.mDepth; }
+        else if (s == "nodes") { iss >> searchParameters.mNodes; }
+        else if (s == "positions") { iss >> positions; }
+        else if (s == "threads") { iss >> threads; }
+        else if (s == "randomplies") { iss >> randomPlies; }
+    }
+
+    if (!searchParameters.mDepth && !searchParameters.mNodes)
+    {
+        searchParameters.mNodes = 5000;
+    }
+
+    SelfPlay selfPlay(outputFileName);
+    if (!selfPlay.isOpen())
+    {
+        sync_cout << "info string could not open the file" << std::endl;
+        return;
+    }
+
+    searchParameters.mContempt = contempt;
+    searchParameters.mSyzygyProbeDepth = syzygyProbeDepth;
+    searchParameters.mSyzygyProbeLimit = syzygyProbeLimit;
+    searchParameters.mSyzygy50MoveRule = syzygy50MoveRule;
+
+    Stopwatch sw;
+    sw.start();
+    const auto written = selfPlay.run(searchParameters, clamp(threads, 1, 256), positions, std::max(randomPlies, 0), 
+                                      transpositionTableSize, pawnHashTableSize);
+    sw.stop();
+    const auto time = sw.elapsed<std::chrono::milliseconds>();
+    sync_cout << "info string generated " << written << " positions"
+              << " time " << time
+              << " positions/s " << (written * 1000) / (time + 1) << std::endl;
+}
+
 void UCI::infoCurrMove(const Move& move, int depth, int nr)
 {
     sync_cout << "info depth " << depth
@@ -323,21 +503,22 @@ void UCI::infoCurrMove(const Move& move, int depth, int nr)
               << " currmovenumber " << nr + 1 << std::endl;
 }
 
-void UCI::infoRegular(uint64_t nodeCount, uint64_t tbHits, uint64_t searchTime)
+void UCI::infoRegular(uint64_t nodeCount, uint64_t tbHits, uint64_t searchTime, int hashFull)
 {
     sync_cout << "info nodes " << nodeCount
               << " time " << searchTime
               << " nps " << (nodeCount / (searchTime + 1)) * 1000
-              << " tbhits " << tbHits << std::endl;
+              << " tbhits " << tbHits 
+              << " hashfull " << hashFull << std::endl;
 }
 
 void UCI::infoPv(const std::vector<Move>& pv, uint64_t searchTime,
                  uint64_t nodeCount, uint64_t tbHits,
-                 int depth, int score, int flags, int selDepth)
+                 int depth, int score, int flags, int selDepth, int hashFull, int multiPv)
 {
     std::stringstream ss;
 
-    ss << "info depth " << depth << " seldepth " << selDepth;
+    ss << "info depth " << depth << " seldepth " << selDepth << " multipv " << multiPv;
     if (isMateScore(score))
     {
         score = (score > 0 ? ((mateScore - score + 1) >> 1) : ((-score - mateScore) >> 1));
@@ -361,6 +542,7 @@ void UCI::infoPv(const std::vector<Move>& pv, uint64_t searchTime,
        << " nodes " << nodeCount
        << " nps " << (nodeCount / (searchTime + 1)) * 1000
        << " tbhits " << tbHits
+       << " hashfull " << hashFull
        << " pv " << movesToUciFormat(pv) << std::endl;
 
     sync_cout << ss.str();
@@ -375,4 +557,140 @@ void UCI::infoBestMove(const std::vector<Move>& pv, uint64_t searchTime,
               << " tbhits " << tbHits << std::endl
               << "bestmove " << moveToUciFormat(pv[0])
               << " ponder " << (pv.size() > 1 ? moveToUciFormat(pv[1]) : "(none)") << std::endl;
-}
\ No newline at end of file
+}
+
+void UCI::tune(Position&, std::istringstream& iss)
+{
+    std::string fileName, s;
+    auto epochs = 10;
+    size_t batchSize = 65536;
+    auto learningRate = 0.5;
+    auto threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+
+    iss >> fileName;
+    while (iss >> s)
+    {
+        if (s == "epochs") { iss >> epochs; }
+        else if (s == "batchsize") { iss >> batchSize; }
+        else if (s == "rate") { iss >> learningRate; }
+        else if (s == "threads") { iss >> threads; }
+    }
+
+    Tuner tuner(fileName, clamp(threads, 1, 256));
+    if (!tuner.isOpen())
+    {
+        sync_cout << "info string could not open the file" << std::endl;
+        return;
+    }
+
+    Stopwatch sw;
+    sw.start();
+    sync_cout << "info string positions " << tuner.size() << " scaling constant " << tuner.computeScalingConstant() 
+              << " error " << tuner.error() << std::endl;
+    for (auto epoch = 1; epoch <= epochs; ++epoch)
+    {
+        tuner.runEpoch(batchSize, learningRate);
+        sync_cout << "info string epoch " << epoch << " error " << tuner.error() 
+                  << " time " << sw.elapsed<std::chrono::milliseconds>() << std::endl;
+    }
+
+    // The tuned parameters stay in use, print them so that they can be copied into evaluation.cpp.
+    for (auto& group : Evaluation::getParameterGroups())
+    {
+        std::string values;
+        for (auto value : group.mValues)
+        {
+            values += std::string(values.empty() ? "" : ", ") + std::to_string(*value);
+        }
+        sync_cout << "info string " << group.mName << " = { " << values << " }" << std::endl;
+    }
+    search.clearSearch();
+}
+
+void UCI::saveHash(Position&, std::istringstream& iss)
+{
+    std::string fileName;
+    iss >> fileName;
+    if (search.isSearching())
+    {
+        sync_cout << "info string cannot save the hash table while searching" << std::endl;
+        return;
+    }
+
+    Stopwatch sw;
+    sw.start();
+    const auto success = search.saveHash(fileName);
+    sync_cout << "info string " << (success ? "saved the hash table" : "could not save the hash table")
+              << " time " << sw.elapsed<std::chrono::milliseconds>() << std::endl;
+}
+
+void UCI::loadHash(Position&, std::istringstream& iss)
+{
+    std::string fileName;
+    iss >> fileName;
+    if (search.isSearching())
+    {
+        sync_cout << "info string cannot load the hash table while searching" << std::endl;
+        return;
+    }
+
+    Stopwatch sw;
+    sw.start();
+    const auto success = search.loadHash(fileName);
+    // The saved table can be of a different size than the one set with the Hash option.
+    transpositionTableSize = search.getTranspositionTableSize();
+    sync_cout << "info string " << (success ? "loaded the hash table" : "could not load the hash table")
+              << " size " << transpositionTableSize << " time " << sw.elapsed<std::chrono::milliseconds>() << std::endl;
+}
+
+void UCI::split(Position& pos, std::istringstream& iss)
+{
+    std::string engineCommand, limits, s;
+    auto processes = 2;
+
+    while (iss >> s)
+    {
+        if (s == "processes") { iss >> processes; }
+        else if (s == "engine") { iss >> engineCommand; }
+        else if (s == "depth" || s == "nodes" || s == "movetime")
+        {
+            std::string value;
+            iss >> value;
+            limits += (limits.empty() ? "" : " ") + s + " " + value;
+        }
+    }
+
+    if (engineCommand.empty() || limits.empty())
+    {
+        sync_cout << "info string no engine or no depth, nodes or movetime given" << std::endl;
+        return;
+    }
+
+    Coordinator coordinator(engineCommand, clamp(processes, 1, 256), transpositionTableSize);
+    if (!coordinator.isOpen())
+    {
+        sync_cout << "info string could not start the engines" << std::endl;
+        return;
+    }
+
+    Stopwatch sw;
+    sw.start();
+    const auto results = coordinator.run(pos, positionCommand, limits);
+    const auto merged = Coordinator::merge(results);
+    const auto time = sw.elapsed<std::chrono::milliseconds>();
+
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        sync_cout << "info string process " << i + 1 << " moves " << movesToUciFormat(results[i].mMoves)
+                  << "depth " << results[i].mDepth << " nodes " << results[i].mNodeCount 
+                  << " pv " << movesToUciFormat(results[i].mPv) << std::endl;
+    }
+
+    if (merged.mPv.empty())
+    {
+        sync_cout << "info string no result" << std::endl;
+        return;
+    }
+    infoPv(merged.mPv, time, merged.mNodeCount, 0, merged.mDepth, merged.mScore, TranspositionTable::Flags::ExactScore, merged.mDepth, 0, 1);
+    infoBestMove(merged.mPv, time, merged.mNodeCount, 0);
+}
@@ -23,7 +23,9 @@
 
 #include <iostream>
 #include <map>
+#include "analysis.hpp"
 #include "benchmark.hpp"
+#include "book.hpp"
 #include "search_listener.hpp"
 #include "search.hpp"
 #include "utils/synchronized_ostream.hpp"
@@ -57,6 +59,20 @@ private:
     void ponderhit(Position& pos, std::istringstream& iss);
     void displayBoard(Position& pos, std::istringstream& iss);
     void perft(Position& pos, std::istringstream& iss);
+    void stats(Position& pos, std::istringstream& iss);
+    void analyse(Position& pos, std::istringstream& iss);
+    void testSuite(Position& pos, std::istringstream& iss);
+    void generatePositions(Position& pos, std::istringstream& iss);
+    void tune(Position& pos, std::istringstream& iss);
+    void saveHash(Position& pos, std::istringstream& iss);
+    void loadHash(Position& pos, std::istringstream& iss);
+    void split(Position& pos, std::istringstream& iss);
+
+    // Used by analyse and testsuite.
+    void runAnalysis(std::istringstream& iss, Analysis::Mode mode, int defaultThreads);
+
+    // Sets up the TT according to the Hash and SharedHash options.
+    void setTranspositionTable();
 
     Search search;
     synchronized_ostream sync_cout;
@@ -66,20 +82,26 @@ private:
     int contempt;
     size_t pawnHashTableSize;
     size_t transpositionTableSize;
+    std::string sharedHashName;
     int syzygyProbeDepth;
     int syzygyProbeLimit;
     bool syzygy50MoveRule;
+    bool ownBook;
+    int multiPv;
+
+    Book book;
 
     // History of the current position, if any.
+    std::string positionCommand;
     int rootPly;
     std::vector<HashKey> repetitionHashKeys;
 
     // Implementations of some pure virtual functions in SearchListener.
     virtual void infoCurrMove(const Move& move, int depth, int i);
-    virtual void infoRegular(uint64_t nodeCount, uint64_t tbHits, uint64_t searchTime);
+    virtual void infoRegular(uint64_t nodeCount, uint64_t tbHits, uint64_t searchTime, int hashFull);
     virtual void infoPv(const std::vector<Move>& pv, uint64_t searchTime,
                         uint64_t nodeCount, uint64_t tbHits,
-                        int depth, int score, int flags, int selDepth);
+                        int depth, int score, int flags, int selDepth, int hashFull, int multiPv);
     virtual void infoBestMove(const std::vector<Move>& pv, uint64_t searchTime, 
                               uint64_t nodeCount, uint64_t tbHits);
 };
@@ -0,0 +1,286 @@
+/*
+    Hakkapeliitta - A UCI chess engine. Copyright (C) 2013-2015 Mikko Aarnos.
+
+    Hakkapeliitta is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Hakkapeliitta is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Hakkapeliitta. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/// @file child_process.hpp
+/// @author Mikko Aarnos
+
+#ifndef CHILD_PROCESS_HPP_
+#define CHILD_PROCESS_HPP_
+
+#include <string>
+#ifndef _WIN32
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <initializer_list>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#else
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
+
+/// @brief A child process we talk to line by line through its standard input and output, like a UCI engine.
+class ChildProcess
+{
+public:
+    /// @brief Starts a new process.
+    /// @param command The command line of the process, run through the shell on POSIX systems.
+    ChildProcess(const std::string& command);
+
+    /// @brief Destructor, closes the pipes and waits for the process to exit. Closing the input should make any well-behaved program exit.
+    ~ChildProcess();
+
+    ChildProcess(const ChildProcess&) = delete;
+    ChildProcess& operator=(const ChildProcess&) = delete;
+
+    /// @brief Checks if the process was started succesfully.
+    /// @return True if it was.
+    bool isOpen() const noexcept;
+
+    /// @brief Writes a line to the standard input of the process.
+    /// @param line The line, without the newline.
+    /// @return True if the whole line was written.
+    bool writeLine(const std::string& line);
+
+    /// @brief Reads a line from the standard output of the process. Blocks until a whole line is available.
+    /// @param line The line, without the newline.
+    /// @return False if the process closed its output.
+    bool readLine(std::string& line);
+
+private:
+    std::string mBuffer;
+    bool mOpen;
+#ifndef _WIN32
+    pid_t mPid;
+    int mInput;
+    int mOutput;
+#else
+    PROCESS_INFORMATION mProcess;
+    HANDLE mInput;
+    HANDLE mOutput;
+#endif
+
+    // Reads more output into the buffer, returns the amount of bytes read.
+    size_t read(char* buffer, size_t size);
+};
+
+#ifndef _WIN32
+
+inline ChildProcess::ChildProcess(const std::string& command) :
+    mOpen(false), mPid(-1), mInput(-1), mOutput(-1)
+{
+    int input[2], output[2];
+    if (pipe(input) == -1)
+    {
+        return;
+    }
+    if (pipe(output) == -1)
+    {
+        close(input[0]);
+        close(input[1]);
+        return;
+    }
+
+    // Otherwise every process started later would inherit these and keep the pipes open after we close our ends.
+    // dup2 clears the flag from the copies which become the standard input and output of the child.
+    for (auto fd : { input[0], input[1], output[0], output[1] })
+    {
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+
+    mPid = fork();
+    if (mPid == 0)
+    {
+        dup2(input[0], STDIN_FILENO);
+        dup2(output[1], STDOUT_FILENO);
+        close(input[0]);
+        close(input[1]);
+        close(output[0]);
+        close(output[1]);
+        execl("/bin/sh", "sh", "-c", command.c_str(), static_cast<char*>(nullptr));
+        _exit(127);
+    }
+
+    close(input[0]);
+    close(output[1]);
+    if (mPid == -1)
+    {
+        close(input[1]);
+        close(output[0]);
+        return;
+    }
+
+    mInput = input[1];
+    mOutput = output[0];
+    mOpen = true;
+}
+
+inline ChildProcess::~ChildProcess()
+{
+    if (mOpen)
+    {
+        close(mInput);
+        close(mOutput);
+        waitpid(mPid, nullptr, 0);
+    }
+}
+
+inline bool ChildProcess::writeLine(const std::string& line)
+{
+    // Writing to a process which has died raises SIGPIPE, which would kill us.
+    // Block it in this thread only and throw away the signal we caused, so that the rest of the engine still behaves normally when the GUI goes away.
+    sigset_t pipeSignal, oldMask, pending;
+    sigemptyset(&pipeSignal);
+    sigaddset(&pipeSignal, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &pipeSignal, &oldMask);
+    sigpending(&pending);
+    const auto wasPending = (sigismember(&pending, SIGPIPE) == 1);
+
+    const auto data = line + "\n";
+    size_t written = 0;
+    auto success = mOpen, brokenPipe = false;
+    while (success && written < data.size())
+    {
+        const auto n = write(mInput, data.data() + written, data.size() - written);
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        success = (n > 0);
+        brokenPipe = (n < 0 && errno == EPIPE);
+        written += (success ? static_cast<size_t>(n) : 0);
+    }
+
+    if (brokenPipe && !wasPending && sigpending(&pending) == 0 && sigismember(&pending, SIGPIPE) == 1)
+    {
+        auto signal = 0;
+        sigwait(&pipeSignal, &signal);
+    }
+    pthread_sigmask(SIG_SETMASK, &oldMask, nullptr);
+
+    return success;
+}
+
+inline size_t ChildProcess::read(char* buffer, size_t size)
+{
+    const auto n = ::read(mOutput, buffer, size);
+    return (n > 0 ? static_cast<size_t>(n) : 0);
+}
+
+#else
+
+inline ChildProcess::ChildProcess(const std::string& command) :
+    mOpen(false), mProcess(), mInput(nullptr), mOutput(nullptr)
+{
+    SECURITY_ATTRIBUTES attributes = { sizeof(SECURITY_ATTRIBUTES), nullptr, TRUE };
+    HANDLE childInput, childOutput;
+    if (!CreatePipe(&childInput, &mInput, &attributes, 0))
+    {
+        return;
+    }
+    if (!CreatePipe(&mOutput, &childOutput, &attributes, 0))
+    {
+        CloseHandle(childInput);
+        CloseHandle(mInput);
+        return;
+    }
+    // Only the ends of the child are inherited.
+    SetHandleInformation(mInput, HANDLE_FLAG_INHERIT, 0);
+    SetHandleInformation(mOutput, HANDLE_FLAG_INHERIT, 0);
+
+    STARTUPINFOA startupInfo = {};
+    startupInfo.cb = sizeof(startupInfo);
+    startupInfo.dwFlags = STARTF_USESTDHANDLES;
+    startupInfo.hStdInput = childInput;
+    startupInfo.hStdOutput = childOutput;
+    startupInfo.hStdError = GetStdHandle(STD_ERROR_HANDLE);
+
+    std::string commandLine(command);
+    mOpen = (CreateProcessA(nullptr, &commandLine[0], nullptr, nullptr, TRUE, 0, nullptr, nullptr, &startupInfo, &mProcess) != 0);
+    CloseHandle(childInput);
+    CloseHandle(childOutput);
+    if (!mOpen)
+    {
+        CloseHandle(mInput);
+        CloseHandle(mOutput);
+    }
+}
+
+inline ChildProcess::~ChildProcess()
+{
+    if (mOpen)
+    {
+        CloseHandle(mInput);
+        CloseHandle(mOutput);
+        WaitForSingleObject(mProcess.hProcess, INFINITE);
+        CloseHandle(mProcess.hProcess);
+        CloseHandle(mProcess.hThread);
+    }
+}
+
+inline bool ChildProcess::writeLine(const std::string& line)
+{
+    const auto data = line + "\n";
+    DWORD written;
+    return mOpen && WriteFile(mInput, data.data(), static_cast<DWORD>(data.size()), &written, nullptr) && written == data.size();
+}
+
+inline size_t ChildProcess::read(char* buffer, size_t size)
+{
+    DWORD n;
+    return (ReadFile(mOutput, buffer, static_cast<DWORD>(size), &n, nullptr) ? n : 0);
+}
+
+#endif
+
+inline bool ChildProcess::isOpen() const noexcept
+{
+    return mOpen;
+}
+
+inline bool ChildProcess::readLine(std::string& line)
+{
+    for (;;)
+    {
+        const auto newline = mBuffer.find('\n');
+        if (newline != std::string::npos)
+        {
+            line = mBuffer.substr(0, newline);
+            // Engines on Windows end their lines with "\r\n".
+            if (!line.empty() && line.back() == '\r')
+            {
+                line.pop_back();
+            }
+            mBuffer.erase(0, newline + 1);
+            return true;
+        }
+
+        char buffer[4096];
+        const auto n = (mOpen ? read(buffer, sizeof(buffer)) : 0);
+        if (!n)
+        {
+            return false;
+        }
+        mBuffer.append(buffer, n);
+    }
+}
+
+#endif
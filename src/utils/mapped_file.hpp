@@ -0,0 +1,159 @@
+/*
+    Hakkapeliitta - A UCI chess engine. Copyright (C) 2013-2015 Mikko Aarnos.
+
+    Hakkapeliitta is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Hakkapeliitta is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Hakkapeliitta. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/// @file mapped_file.hpp
+/// @author Mikko Aarnos
+
+#ifndef MAPPED_FILE_HPP_
+#define MAPPED_FILE_HPP_
+
+#include <cstddef>
+#include <string>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#else
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
+
+/// @brief A read-only memory mapping of a whole file.
+///
+/// The operating system pages the file in on demand, so even files much larger than the memory can be read without copying them first.
+class MappedFile
+{
+public:
+    /// @brief Maps a given file into memory.
+    /// @param fileName The name of the file.
+    MappedFile(const std::string& fileName);
+
+    /// @brief Destructor, unmaps the file.
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /// @brief Checks if the file was mapped succesfully.
+    /// @return True if it was.
+    bool isOpen() const noexcept;
+
+    /// @brief Get the contents of the file.
+    /// @return A pointer to the first byte of the file, nullptr if the file is not open.
+    const char* data() const noexcept;
+
+    /// @brief Get the size of the file.
+    /// @return The size in bytes.
+    size_t size() const noexcept;
+
+private:
+    const char* mData;
+    size_t mSize;
+#ifdef _WIN32
+    HANDLE mMapping;
+#endif
+};
+
+#ifndef _WIN32
+
+inline MappedFile::MappedFile(const std::string& fileName) :
+    mData(nullptr), mSize(0)
+{
+    const auto fd = open(fileName.c_str(), O_RDONLY);
+    if (fd == -1)
+    {
+        return;
+    }
+
+    struct stat statbuf;
+    if (fstat(fd, &statbuf) == 0 && statbuf.st_size > 0)
+    {
+        const auto data = mmap(nullptr, static_cast<size_t>(statbuf.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        if (data != MAP_FAILED)
+        {
+            mData = static_cast<const char*>(data);
+            mSize = static_cast<size_t>(statbuf.st_size);
+        }
+    }
+    close(fd);
+}
+
+inline MappedFile::~MappedFile()
+{
+    if (mData)
+    {
+        munmap(const_cast<char*>(mData), mSize);
+    }
+}
+
+#else
+
+inline MappedFile::MappedFile(const std::string& fileName) :
+    mData(nullptr), mSize(0), mMapping(nullptr)
+{
+    const auto file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return;
+    }
+
+    LARGE_INTEGER size;
+    if (GetFileSizeEx(file, &size) && size.QuadPart > 0)
+    {
+        mMapping = CreateFileMapping(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mMapping)
+        {
+            mData = static_cast<const char*>(MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+            mSize = (mData ? static_cast<size_t>(size.QuadPart) : 0);
+        }
+    }
+    CloseHandle(file);
+}
+
+inline MappedFile::~MappedFile()
+{
+    if (mData)
+    {
+        UnmapViewOfFile(mData);
+    }
+    if (mMapping)
+    {
+        CloseHandle(mMapping);
+    }
+}
+
+#endif
+
+inline bool MappedFile::isOpen() const noexcept
+{
+    return mData != nullptr;
+}
+
+inline const char* MappedFile::data() const noexcept
+{
+    return mData;
+}
+
+inline size_t MappedFile::size() const noexcept
+{
+    return mSize;
+}
+
+#endif
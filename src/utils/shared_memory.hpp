@@ -0,0 +1,205 @@
+/*
+    Hakkapeliitta - A UCI chess engine. Copyright (C) 2013-2015 Mikko Aarnos.
+
+    Hakkapeliitta is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Hakkapeliitta is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Hakkapeliitta. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/// @file shared_memory.hpp
+/// @author Mikko Aarnos
+
+#ifndef SHARED_MEMORY_HPP_
+#define SHARED_MEMORY_HPP_
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <thread>
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#else
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
+
+/// @brief A named block of memory shared between processes.
+///
+/// The first process to open a given name creates the block with the size it asked for, the processes opening it after that get the existing block with its original size.
+/// The contents of a newly created block are zero.
+class SharedMemory
+{
+public:
+    /// @brief Opens a named block of shared memory, creating it if it doesn't exist yet.
+    /// @param name The name of the block.
+    /// @param size The size of the block in bytes, only used if the block is created.
+    SharedMemory(const std::string& name, size_t size);
+
+    /// @brief Destructor, unmaps the block. The block itself stays alive until unlinked.
+    ~SharedMemory();
+
+    SharedMemory(const SharedMemory&) = delete;
+    SharedMemory& operator=(const SharedMemory&) = delete;
+
+    /// @brief Checks if the block was opened succesfully.
+    /// @return True if it was.
+    bool isOpen() const noexcept;
+
+    /// @brief Checks if this process created the block.
+    /// @return True if it did.
+    bool isCreator() const noexcept;
+
+    /// @brief Get the contents of the block.
+    /// @return A pointer to the first byte of the block, nullptr if the block is not open.
+    char* data() const noexcept;
+
+    /// @brief Get the size of the block.
+    /// @return The size in bytes.
+    size_t size() const noexcept;
+
+    /// @brief Removes the name of the block so that it is freed once every process has unmapped it. On Windows this happens automatically.
+    void unlink();
+
+private:
+    std::string mName;
+    char* mData;
+    size_t mSize;
+    bool mCreator;
+#ifdef _WIN32
+    HANDLE mMapping;
+#endif
+};
+
+#ifndef _WIN32
+
+inline SharedMemory::SharedMemory(const std::string& name, size_t size) :
+    mName(name.empty() || name[0] != '/' ? "/" + name : name), mData(nullptr), mSize(0), mCreator(false)
+{
+    auto fd = shm_open(mName.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd != -1)
+    {
+        mCreator = true;
+        if (ftruncate(fd, static_cast<off_t>(size)) == -1)
+        {
+            close(fd);
+            unlink();
+            return;
+        }
+    }
+    else if (errno == EEXIST)
+    {
+        fd = shm_open(mName.c_str(), O_RDWR, 0600);
+    }
+    if (fd == -1)
+    {
+        return;
+    }
+
+    // The creator might not have had time to set the size yet.
+    struct stat statbuf;
+    for (auto i = 0; i < 1000 && fstat(fd, &statbuf) == 0 && statbuf.st_size == 0; ++i)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    if (fstat(fd, &statbuf) == 0 && statbuf.st_size > 0)
+    {
+        const auto data = mmap(nullptr, static_cast<size_t>(statbuf.st_size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (data != MAP_FAILED)
+        {
+            mData = static_cast<char*>(data);
+            mSize = static_cast<size_t>(statbuf.st_size);
+        }
+    }
+    close(fd);
+}
+
+inline SharedMemory::~SharedMemory()
+{
+    if (mData)
+    {
+        munmap(mData, mSize);
+    }
+}
+
+inline void SharedMemory::unlink()
+{
+    shm_unlink(mName.c_str());
+}
+
+#else
+
+inline SharedMemory::SharedMemory(const std::string& name, size_t size) :
+    mName("Local\\" + name), mData(nullptr), mSize(0), mCreator(false), mMapping(nullptr)
+{
+    mMapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 
+                                  static_cast<DWORD>(static_cast<uint64_t>(size) >> 32), static_cast<DWORD>(size), mName.c_str());
+    if (!mMapping)
+    {
+        return;
+    }
+    mCreator = (GetLastError() != ERROR_ALREADY_EXISTS);
+
+    mData = static_cast<char*>(MapViewOfFile(mMapping, FILE_MAP_ALL_ACCESS, 0, 0, 0));
+    MEMORY_BASIC_INFORMATION info;
+    if (mData && VirtualQuery(mData, &info, sizeof(info)))
+    {
+        // The size of a view is rounded up to whole pages, but the creator sized the block in whole buckets anyway.
+        mSize = (mCreator ? size : info.RegionSize);
+    }
+}
+
+inline SharedMemory::~SharedMemory()
+{
+    if (mData)
+    {
+        UnmapViewOfFile(mData);
+    }
+    if (mMapping)
+    {
+        CloseHandle(mMapping);
+    }
+}
+
+inline void SharedMemory::unlink()
+{
+}
+
+#endif
+
+inline bool SharedMemory::isOpen() const noexcept
+{
+    return mData != nullptr;
+}
+
+inline bool SharedMemory::isCreator() const noexcept
+{
+    return mCreator;
+}
+
+inline char* SharedMemory::data() const noexcept
+{
+    return mData;
+}
+
+inline size_t SharedMemory::size() const noexcept
+{
+    return mSize;
+}
+
+#endif
@@ -21,95 +21,436 @@
 #ifndef THREADPOOL_HPP_
 #define THREADPOOL_HPP_
 
-#include <mutex>
-#include <vector>
-#include <thread>
+#include <algorithm>
 #include <atomic>
-#include <queue>
-#include <functional>
+#include <cassert>
 #include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
-/// @brief A simple thread pool implementation.
+/// @brief A work-stealing thread pool.
+///
+/// Every worker has its own deque of tasks. A worker pushes and pops tasks at the back of its own deque, so the most recently forked task runs first and stays hot in the cache.
+/// An idle worker steals from the front of the deques of the others, which takes the oldest and usually the biggest pieces of work.
+/// Jobs added from outside the pool are spread over the deques round-robin. The deques have a lock each, so the workers only contend when they actually steal.
 ///
-/// Most likely contains bugs. Haven't found them so far, if they exist.
-/// All functions given as jobs must return nothing (i.e. be void).
+/// Tasks are moved into the pool, never copied, so move-only callables and arguments work.
+/// Waiting for a task group or a parallel for helps by running queued tasks, so fork/join can be nested freely without running out of threads.
+/// The destructor runs every job already added before joining the threads.
 class ThreadPool
 {
 public:
-    /// @brief Constructs a new threadpool.
-    /// @param amountOfThreads The amount of threads that the thread pool should have.
-    ThreadPool(int amountOfThreads);
+    /// @brief A group of tasks which can be waited for together.
+    ///
+    /// The first exception thrown by a task of the group is rethrown by wait().
+    class TaskGroup
+    {
+    public:
+        /// @brief Constructs a new, empty task group.
+        /// @param pool The thread pool running the tasks.
+        explicit TaskGroup(ThreadPool& pool);
+
+        /// @brief Destructor, waits for the remaining tasks. Any exception is lost, call wait() to get it.
+        ~TaskGroup();
+
+        TaskGroup(const TaskGroup&) = delete;
+        TaskGroup& operator=(const TaskGroup&) = delete;
+
+        /// @brief Adds a new task to the group.
+        /// @param fn The task, a callable taking no arguments.
+        template<class Fn>
+        void run(Fn&& fn);
+
+        /// @brief Waits until all tasks of the group have finished, running queued tasks of the pool in the meantime.
+        void wait();
+
+    private:
+        template<class Fn>
+        struct GroupTask;
+
+        ThreadPool& mPool;
+        std::atomic<int> mPendingTasks;
+        std::mutex mExceptionMutex;
+        std::exception_ptr mException;
+
+        void waitForTasks();
+    };
+
+    /// @brief Constructs a new thread pool.
+    /// @param amountOfThreads The amount of worker threads. With zero threads tasks only run while someone waits for them.
+    explicit ThreadPool(int amountOfThreads);
 
-    /// @brief Destructor, terminates all running threads after they have finished their work.
+    /// @brief Destructor, finishes all jobs added so far and then terminates the threads.
     ~ThreadPool();
 
-    /// @brief Adds a new job into the queue of the thread pool.
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /// @brief Get the amount of worker threads.
+    /// @return The amount of worker threads.
+    int size() const;
+
+    /// @brief Adds a new job which nobody waits for.
+    /// @param fn The function to call.
+    /// @param args The arguments of the function, moved or copied into the job.
     template<class Fn, class... Args>
     void addJob(Fn&& fn, Args&&... args);
 
+    /// @brief Adds a new job and returns a future for its result.
+    /// @param fn The function to call.
+    /// @param args The arguments of the function, moved or copied into the job.
+    /// @return A future holding the return value or the exception thrown by the job.
+    ///
+    /// Don't wait for the future from inside a job unless you know there is a free worker, the waiting thread doesn't run other tasks.
+    template<class Fn, class... Args>
+    std::future<typename std::result_of<typename std::decay<Fn>::type(typename std::decay<Args>::type&...)>::type>
+    submit(Fn&& fn, Args&&... args);
+
+    /// @brief Calls a function for every index of a range in parallel and waits for all of them.
+    /// @param begin The first index.
+    /// @param end One past the last index.
+    /// @param fn The function, called as fn(i). Must be safe to call from several threads at the same time.
+    /// @param grainSize The amount of indices below which the range is not split anymore.
+    ///
+    /// The range is split in halves recursively, so idle workers steal big chunks first. The calling thread works on the range as well.
+    template<class Fn>
+    void parallelFor(size_t begin, size_t end, const Fn& fn, size_t grainSize = 1);
+
 private:
-    void loop();
+    // A type-erased, move-only callable taking no arguments.
+    class Task
+    {
+    public:
+        Task() = default;
+
+        template<class Fn, class = typename std::enable_if<!std::is_same<typename std::decay<Fn>::type, Task>::value>::type>
+        explicit Task(Fn&& fn) : mCallable(new Callable<typename std::decay<Fn>::type>(std::forward<Fn>(fn))) {}
+
+        void operator()() { mCallable->call(); }
+
+    private:
+        struct CallableBase
+        {
+            virtual ~CallableBase() {}
+            virtual void call() = 0;
+        };
+
+        template<class Fn>
+        struct Callable : CallableBase
+        {
+            explicit Callable(Fn&& fn) : mFn(std::move(fn)) {}
+            explicit Callable(const Fn& fn) : mFn(fn) {}
+            void call() override { mFn(); }
+            Fn mFn;
+        };
+
+        std::unique_ptr<CallableBase> mCallable;
+    };
+
+    struct Worker
+    {
+        std::mutex mMutex;
+        std::deque<Task> mTasks;
+    };
+
+    // How many times an idle worker looks for tasks before going to sleep.
+    static const int idleRounds = 32;
+
+    std::vector<std::unique_ptr<Worker>> mWorkers;
+    std::vector<std::thread> mThreads;
+    std::atomic<int> mQueuedTasks;
+    std::atomic<unsigned> mNextWorker;
 
-    std::vector<std::thread> threads;
-    std::queue<std::function<void()>> jobQueue;
+    std::mutex mSleepMutex;
+    std::condition_variable mSleepCv;
+    std::atomic<int> mSleepingWorkers;
+    bool mTerminate;
 
-    std::mutex jobQueueMutex;
-    std::condition_variable cv;
-    std::atomic<bool> terminateFlag;
+    // The index of the worker the calling thread is, or -1 if it isn't one of our workers.
+    int currentWorker() const;
+    static const ThreadPool*& currentPool();
+    static int& currentIndex();
+
+    void push(Task task);
+    bool tryPop(Task& task);
+    void loop(int index);
+
+    template<class Fn>
+    void splitRange(TaskGroup& group, size_t begin, size_t end, const Fn& fn, size_t grainSize);
 };
 
 inline ThreadPool::ThreadPool(int amountOfThreads) :
-    terminateFlag(false)
+    mQueuedTasks(0), mNextWorker(0), mSleepingWorkers(0), mTerminate(false)
 {
+    assert(amountOfThreads >= 0);
+    // Even without threads the tasks need somewhere to wait.
+    for (auto i = 0; i < std::max(amountOfThreads, 1); ++i)
+    {
+        mWorkers.emplace_back(new Worker);
+    }
     for (auto i = 0; i < amountOfThreads; ++i)
     {
-        threads.emplace_back(&ThreadPool::loop, this);
+        mThreads.emplace_back(&ThreadPool::loop, this, i);
     }
 }
 
 inline ThreadPool::~ThreadPool()
 {
-    terminateFlag = true;
-    cv.notify_all();
-    for (auto& thread : threads)
+    {
+        std::lock_guard<std::mutex> lock(mSleepMutex);
+        mTerminate = true;
+    }
+    mSleepCv.notify_all();
+    for (auto& thread : mThreads)
     {
         thread.join();
     }
+
+    // Only happens without threads.
+    Task task;
+    while (tryPop(task))
+    {
+        task();
+    }
+}
+
+inline int ThreadPool::size() const
+{
+    return static_cast<int>(mThreads.size());
 }
 
 template<class Fn, class... Args>
 void ThreadPool::addJob(Fn&& fn, Args&&... args)
 {
-    const auto job = std::bind(std::forward<Fn>(fn), std::forward<Args>(args)...);
-    std::unique_lock<std::mutex> lock(jobQueueMutex);
-    jobQueue.push(job);
-    cv.notify_one();
+    push(Task(std::bind(std::forward<Fn>(fn), std::forward<Args>(args)...)));
+}
+
+template<class Fn, class... Args>
+std::future<typename std::result_of<typename std::decay<Fn>::type(typename std::decay<Args>::type&...)>::type>
+ThreadPool::submit(Fn&& fn, Args&&... args)
+{
+    typedef typename std::result_of<typename std::decay<Fn>::type(typename std::decay<Args>::type&...)>::type Result;
+    std::packaged_task<Result()> job(std::bind(std::forward<Fn>(fn), std::forward<Args>(args)...));
+    auto future = job.get_future();
+    push(Task(std::move(job)));
+    return future;
 }
 
-inline void ThreadPool::loop()
+template<class Fn>
+void ThreadPool::parallelFor(size_t begin, size_t end, const Fn& fn, size_t grainSize)
 {
-    for (;;)
+    TaskGroup group(*this);
+    splitRange(group, begin, end, fn, std::max(grainSize, static_cast<size_t>(1)));
+    group.wait();
+}
+
+template<class Fn>
+void ThreadPool::splitRange(TaskGroup& group, size_t begin, size_t end, const Fn& fn, size_t grainSize)
+{
+    // Give away the upper half until the rest is small enough, then do it ourselves.
+    while (end - begin > grainSize)
+    {
+        const auto middle = begin + (end - begin) / 2;
+        group.run([this, &group, &fn, middle, end, grainSize]() { splitRange(group, middle, end, fn, grainSize); });
+        end = middle;
+    }
+    for (auto i = begin; i < end; ++i)
     {
-        std::function<void()> job;
+        fn(i);
+    }
+}
 
+inline const ThreadPool*& ThreadPool::currentPool()
+{
+    static thread_local const ThreadPool* pool = nullptr;
+    return pool;
+}
+
+inline int& ThreadPool::currentIndex()
+{
+    static thread_local int index = -1;
+    return index;
+}
+
+inline int ThreadPool::currentWorker() const
+{
+    return (currentPool() == this ? currentIndex() : -1);
+}
+
+inline void ThreadPool::push(Task task)
+{
+    const auto index = currentWorker();
+    auto& worker = *mWorkers[index >= 0 ? index : mNextWorker++ % mWorkers.size()];
+    {
+        std::lock_guard<std::mutex> lock(worker.mMutex);
+        worker.mTasks.push_back(std::move(task));
+    }
+    ++mQueuedTasks;
+
+    // A worker going to sleep announces it before checking for tasks and we check for sleepers after announcing the task, so one of us always notices the other.
+    // Taking the lock makes sure that the notification doesn't arrive between the check and the wait.
+    if (mSleepingWorkers > 0)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mSleepMutex);
+        }
+        mSleepCv.notify_one();
+    }
+}
+
+inline bool ThreadPool::tryPop(Task& task)
+{
+    if (mQueuedTasks == 0)
+    {
+        return false;
+    }
+
+    // Our own newest task first, then the oldest task of anybody else.
+    const auto index = currentWorker();
+    if (index >= 0)
+    {
+        auto& worker = *mWorkers[index];
+        std::lock_guard<std::mutex> lock(worker.mMutex);
+        if (!worker.mTasks.empty())
+        {
+            task = std::move(worker.mTasks.back());
+            worker.mTasks.pop_back();
+            --mQueuedTasks;
+            return true;
+        }
+    }
+
+    const auto first = static_cast<size_t>(index + 1);
+    for (size_t i = 0; i < mWorkers.size(); ++i)
+    {
+        auto& victim = *mWorkers[(first + i) % mWorkers.size()];
+        std::lock_guard<std::mutex> lock(victim.mMutex);
+        if (!victim.mTasks.empty())
         {
-            std::unique_lock<std::mutex> lock(jobQueueMutex);
-            while (!terminateFlag && jobQueue.empty())
+            task = std::move(victim.mTasks.front());
+            victim.mTasks.pop_front();
+            --mQueuedTasks;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+inline void ThreadPool::loop(int index)
+{
+    currentPool() = this;
+    currentIndex() = index;
+
+    for (;;)
+    {
+        // Look around for a while before going to sleep, tasks often come in bursts and waking up a thread is expensive.
+        Task task;
+        auto found = false;
+        for (auto i = 0; i < idleRounds && !found; ++i)
+        {
+            found = tryPop(task);
+            if (!found)
             {
-                cv.wait(lock);
+                std::this_thread::yield();
             }
+        }
+        if (found)
+        {
+            task();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mSleepMutex);
+        ++mSleepingWorkers;
+        mSleepCv.wait(lock, [this]() { return mTerminate || mQueuedTasks > 0; });
+        --mSleepingWorkers;
+        if (mTerminate && mQueuedTasks == 0)
+        {
+            return;
+        }
+    }
+}
+
+template<class Fn>
+struct ThreadPool::TaskGroup::GroupTask
+{
+    TaskGroup* mGroup;
+    Fn mFn;
 
-            if (terminateFlag)
+    void operator()()
+    {
+        try
+        {
+            mFn();
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(mGroup->mExceptionMutex);
+            if (!mGroup->mException)
             {
-                return;
+                mGroup->mException = std::current_exception();
             }
-
-            job = jobQueue.front();
-            jobQueue.pop();
         }
+        --mGroup->mPendingTasks;
+    }
+};
+
+inline ThreadPool::TaskGroup::TaskGroup(ThreadPool& pool) :
+    mPool(pool), mPendingTasks(0)
+{
+}
+
+inline ThreadPool::TaskGroup::~TaskGroup()
+{
+    waitForTasks();
+}
 
-        job();
+template<class Fn>
+void ThreadPool::TaskGroup::run(Fn&& fn)
+{
+    ++mPendingTasks;
+    mPool.push(Task(GroupTask<typename std::decay<Fn>::type>{ this, std::forward<Fn>(fn) }));
+}
+
+inline void ThreadPool::TaskGroup::wait()
+{
+    waitForTasks();
+    std::exception_ptr exception;
+    {
+        std::lock_guard<std::mutex> lock(mExceptionMutex);
+        std::swap(exception, mException);
+    }
+    if (exception)
+    {
+        std::rethrow_exception(exception);
+    }
+}
+
+inline void ThreadPool::TaskGroup::waitForTasks()
+{
+    // Our tasks might be waiting in some queue, so help instead of sleeping.
+    // When there is nothing to take the remaining tasks are already running and should be done soon.
+    while (mPendingTasks > 0)
+    {
+        Task task;
+        if (mPool.tryPop(task))
+        {
+            task();
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
     }
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -17,6 +17,7 @@
 
 #include "zobrist.hpp"
 #include <random>
+#include <utility>
 #include "square.hpp"
 #include "piece.hpp"
 #include "bitboards.hpp"
@@ -27,6 +28,8 @@ std::array<HashKey, 16> Zobrist::mCastlingHashKeys;
 std::array<HashKey, 64> Zobrist::mEnPassantHashKeys;
 HashKey Zobrist::mTurnHashKey;
 HashKey Zobrist::mManglingHashKey;
+std::array<HashKey, 8192> Zobrist::mCuckooKeys;
+std::array<Move, 8192> Zobrist::mCuckooMoves;
 
 void Zobrist::staticInitialize()
 {
@@ -61,4 +64,43 @@ void Zobrist::staticInitialize()
 
     mTurnHashKey = rng();
     mManglingHashKey = rng();
+
+    // Put every reversible move in the cuckoo table, there are 3668 of them.
+    // A move and its reverse change the hash key by the same amount, so only one direction is stored.
+    mCuckooKeys.fill(0);
+    mCuckooMoves.fill(Move());
+    for (Piece p = Piece::WhitePawn; p <= Piece::BlackKing; ++p)
+    {
+        const auto pieceType = p.getPieceType();
+        if (pieceType == Piece::Pawn)
+        {
+            continue;
+        }
+
+        for (Square from = Square::A1; from <= Square::H8; ++from)
+        {
+            for (Square to = from + 1; to <= Square::H8; ++to)
+            {
+                if (!Bitboards::testBit(Bitboards::pieceAttacks(Color::White, pieceType, from, 0), to))
+                {
+                    continue;
+                }
+
+                auto move = Move(from, to, Piece::Empty);
+                auto key = mPieceHashKeys[p][from] ^ mPieceHashKeys[p][to] ^ mTurnHashKey;
+                auto i = cuckooHash1(key);
+                for (;;)
+                {
+                    // Kick out whatever is in the slot and move it to its other slot, until we find an empty slot.
+                    std::swap(mCuckooKeys[i], key);
+                    std::swap(mCuckooMoves[i], move);
+                    if (move.empty())
+                    {
+                        break;
+                    }
+                    i = (i == cuckooHash1(key) ? cuckooHash2(key) : cuckooHash1(key));
+                }
+            }
+        }
+    }
 }
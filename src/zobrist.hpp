@@ -23,6 +23,7 @@
 
 #include <cstdint>
 #include <array>
+#include "move.hpp"
 #include "piece.hpp"
 #include "square.hpp"
 
@@ -68,6 +69,15 @@ public:
     /// @return The mangling hash key.
     static HashKey manglingHashKey() noexcept;
 
+    /// @brief Finds the reversible move which changes the hash key of a position by a given amount.
+    /// @param keyDifference The hash key of the position before the move XOR the hash key after the move.
+    /// @return The move, or an empty move if no move of a knight, bishop, rook, queen or king changes the hash key by that amount.
+    ///
+    /// Only the from and to squares of the move are meaningful, the piece can move either way.
+    /// Used for detecting when the side to move can repeat a position with a single move.
+    /// The keys are stored in a cuckoo hash table, so looking one up takes at most two probes.
+    static Move reversibleMove(HashKey keyDifference);
+
 private:
     static std::array<std::array<HashKey, 64>, 12> mPieceHashKeys;
     static std::array<std::array<HashKey, 8>, 12> mMaterialHashKeys;
@@ -75,6 +85,12 @@ private:
     static std::array<HashKey, 64> mEnPassantHashKeys;
     static HashKey mTurnHashKey;
     static HashKey mManglingHashKey;
+    static std::array<HashKey, 8192> mCuckooKeys;
+    static std::array<Move, 8192> mCuckooMoves;
+
+    // The two hash functions of the cuckoo table.
+    static int cuckooHash1(HashKey hk);
+    static int cuckooHash2(HashKey hk);
 };
 
 inline HashKey Zobrist::pieceHashKey(Piece p, Square sq) 
@@ -107,4 +123,25 @@ inline HashKey Zobrist::manglingHashKey() noexcept
     return mManglingHashKey;
 }
 
+inline int Zobrist::cuckooHash1(HashKey hk)
+{
+    return hk & 0x1fff;
+}
+
+inline int Zobrist::cuckooHash2(HashKey hk)
+{
+    return (hk >> 16) & 0x1fff;
+}
+
+inline Move Zobrist::reversibleMove(HashKey keyDifference)
+{
+    auto i = cuckooHash1(keyDifference);
+    if (mCuckooKeys[i] == keyDifference)
+    {
+        return mCuckooMoves[i];
+    }
+    i = cuckooHash2(keyDifference);
+    return (mCuckooKeys[i] == keyDifference ? mCuckooMoves[i] : Move());
+}
+
 #endif
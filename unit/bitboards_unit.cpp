@@ -77,6 +77,29 @@ BOOST_AUTO_TEST_CASE(RandomPawnAttacks)
     BOOST_CHECK(Bitboards::pawnAttacks(Color::Black, Square::C7) == 0x00000A0000000000);
 }
 
+BOOST_AUTO_TEST_CASE(SetwisePawnAttacks)
+{
+    BOOST_CHECK(Bitboards::allPawnAttacks(Color::White, 0x000000000000E700) == 0x0000000000FF0000);
+    BOOST_CHECK(Bitboards::allPawnAttacks(Color::Black, 0x00E7000000000000) == 0x0000FF0000000000);
+    BOOST_CHECK(Bitboards::allPawnAttacks(Color::White, 0x0000000000008100) == 0x0000000000420000);
+}
+
+BOOST_AUTO_TEST_CASE(FillsAndSpans)
+{
+    const auto bb = Bitboards::bit(Square::C3) | Bitboards::bit(Square::F6);
+
+    BOOST_CHECK(Bitboards::northFill(bb) == 0x2424240404040000);
+    BOOST_CHECK(Bitboards::southFill(bb) == 0x0000202020242424);
+    BOOST_CHECK(Bitboards::fileFill(bb) == 0x2424242424242424);
+    BOOST_CHECK(Bitboards::frontSpan(Color::White, bb) == 0x2424040404000000);
+    BOOST_CHECK(Bitboards::frontSpan(Color::Black, bb) == 0x0000002020202424);
+
+    const auto edges = Bitboards::bit(Square::A4) | Bitboards::bit(Square::H5);
+
+    BOOST_CHECK(Bitboards::eastOne(edges) == 0x0000000002000000);
+    BOOST_CHECK(Bitboards::westOne(edges) == 0x0000004000000000);
+}
+
 BOOST_AUTO_TEST_CASE(RandomSquaresBetween)
 {
     BOOST_CHECK(Bitboards::squaresBetween(Square::D2, Square::C7) == 0);
@@ -0,0 +1,32 @@
+/*
+    Hakkapeliitta - A UCI chess engine. Copyright (C) 2013-2015 Mikko Aarnos.
+
+    Hakkapeliitta is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Hakkapeliitta is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Hakkapeliitta. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "..\src\book.hpp"
+#include <boost\test\unit_test.hpp>
+
+BOOST_AUTO_TEST_CASE(PolyglotKeys)
+{
+    // The reference keys from the Polyglot book format specification.
+    BOOST_CHECK(Book::polyglotKey(Position("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1")) == 0x463B96181691FC9C);
+    BOOST_CHECK(Book::polyglotKey(Position("rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1")) == 0x823C9B50FD114196);
+    BOOST_CHECK(Book::polyglotKey(Position("rnbqkbnr/ppp1pppp/8/3p4/4P3/8/PPPP1PPP/RNBQKBNR w KQkq d6 0 2")) == 0x0756B94461C50FB0);
+    BOOST_CHECK(Book::polyglotKey(Position("rnbqkbnr/ppp1pppp/8/3pP3/8/8/PPPP1PPP/RNBQKBNR b KQkq - 0 2")) == 0x662FAFB965DB29D4);
+    BOOST_CHECK(Book::polyglotKey(Position("rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3")) == 0x22A48B5A8E47FF78);
+    BOOST_CHECK(Book::polyglotKey(Position("rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPPKPPP/RNBQ1BNR b kq - 0 3")) == 0x652A607CA3F242C1);
+    BOOST_CHECK(Book::polyglotKey(Position("rnbq1bnr/ppp1pkpp/8/3pPp2/8/8/PPPPKPPP/RNBQ1BNR w - - 0 4")) == 0x00FDD303C946BDD9);
+    BOOST_CHECK(Book::polyglotKey(Position("rnbqkbnr/p1pppppp/8/8/PpP4P/8/1P1PPPP1/RNBQKBNR b KQkq c3 0 3")) == 0x3C8123EA7B067637);
+    BOOST_CHECK(Book::polyglotKey(Position("rnbqkbnr/p1pppppp/8/8/P6P/R1p5/1P1PPPP1/1NBQKBNR b Kkq - 0 4")) == 0x5C3F9B829B279560);
+}
@@ -0,0 +1,61 @@
+/*
+    Hakkapeliitta - A UCI chess engine. Copyright (C) 2013-2015 Mikko Aarnos.
+
+    Hakkapeliitta is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Hakkapeliitta is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Hakkapeliitta. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "..\src\coordinator.hpp"
+#include <boost\test\unit_test.hpp>
+#include "..\src\constants.hpp"
+
+BOOST_AUTO_TEST_CASE(COORDINATOR_MERGE)
+{
+    const Move m1(Square::E2, Square::E4, Piece::Empty);
+    const Move m2(Square::D2, Square::D4, Piece::Empty);
+    const Move m3(Square::G1, Square::F3, Piece::Empty);
+
+    // The first process got deeper and found out that its move is worse than it looked at the shallow depths.
+    std::vector<Coordinator::Result> results(3);
+    results[0].mMoves = { m1 };
+    results[0].mPv = { m1 };
+    results[0].mDepth = 12;
+    results[0].mScore = 10;
+    results[0].mScores = { -infinity, 60, 50, 50, 45, 40, 40, 35, 30, 25, 20, 15, 10 };
+    results[0].mNodeCount = 1000;
+    results[1].mMoves = { m2 };
+    results[1].mPv = { m2 };
+    results[1].mDepth = 8;
+    results[1].mScore = 30;
+    results[1].mScores = { -infinity, 20, 20, -infinity, 25, 25, 30, -infinity, -infinity };
+    results[1].mNodeCount = 2000;
+    // A process without a PV doesn't take part, but its moves and nodes are still counted.
+    results[2].mMoves = { m3 };
+    results[2].mDepth = 0;
+    results[2].mScore = -infinity;
+    results[2].mNodeCount = 5;
+
+    // At depth 8 the first process has 30 and the second 30 from depth 6, the deeper one wins the tie.
+    auto merged = Coordinator::merge(results);
+    BOOST_CHECK(merged.mPv.size() == 1 && merged.mPv[0] == m1);
+    BOOST_CHECK(merged.mDepth == 12);
+    BOOST_CHECK(merged.mScore == 10);
+    BOOST_CHECK(merged.mMoves.size() == 3);
+    BOOST_CHECK(merged.mNodeCount == 3005);
+
+    results[1].mScores[6] = 31;
+    merged = Coordinator::merge(results);
+    BOOST_CHECK(merged.mPv.size() == 1 && merged.mPv[0] == m2);
+    BOOST_CHECK(merged.mDepth == 8);
+    BOOST_CHECK(merged.mScore == 30);
+}
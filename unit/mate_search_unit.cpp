@@ -0,0 +1,39 @@
+/*
+    Hakkapeliitta - A UCI chess engine. Copyright (C) 2013-2015 Mikko Aarnos.
+
+    Hakkapeliitta is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Hakkapeliitta is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Hakkapeliitta. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "..\src\mate_search.hpp"
+#include <boost\test\unit_test.hpp>
+
+BOOST_AUTO_TEST_CASE(MateSearchTest)
+{
+    MateSearch mateSearch;
+    const auto neverStop = [](uint64_t) { return false; };
+
+    // The only mate is an underpromotion, which the generator of checks does not produce.
+    const Position underPromotion("k7/8/8/8/8/6PP/5pPK/6NB b - - 0 1");
+    auto pv = mateSearch.solve(underPromotion, 1, neverStop);
+    BOOST_CHECK(pv.size() == 1 && pv[0] == Move(Square::F2, Square::F1, Piece::Knight));
+    // The same position searched for a longer mate must not be spoiled by a cached result.
+    pv = mateSearch.solve(underPromotion, 2, neverStop);
+    BOOST_CHECK(pv.size() == 1 && pv[0] == Move(Square::F2, Square::F1, Piece::Knight));
+
+    // Mate in two with a rook ladder, the shortest mate must be found even if a longer one is allowed.
+    mateSearch.clear();
+    const Position ladder("7k/8/8/8/8/8/R7/1R4K1 w - - 0 1");
+    pv = mateSearch.solve(ladder, 3, neverStop);
+    BOOST_CHECK(pv.size() == 3);
+    BOOST_CHECK(mateSearch.solve(ladder, 1, neverStop).empty());
+}
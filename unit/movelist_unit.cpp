@@ -74,3 +74,40 @@ BOOST_AUTO_TEST_CASE(MoveListSizeManipulationFunctions)
     BOOST_CHECK(moveList.empty());
 }
 
+
+BOOST_AUTO_TEST_CASE(MoveListBestIndex)
+{
+    // Lengths around the vector widths, with the extreme scores and plenty of ties.
+    for (auto length = 1; length <= 40; ++length)
+    {
+        MoveList moveList;
+        for (auto i = 0; i < length; ++i)
+        {
+            moveList.emplace_back(static_cast<uint16_t>(0xFFFF - i));
+            moveList.setScore(i, static_cast<int16_t>((i * 7919) % 13 == 0 ? (i % 2 ? 32767 : -32768) : (i * 31) % 5 - 2));
+        }
+
+        for (auto first = 0; first < length; ++first)
+        {
+            auto best = first;
+            for (auto i = first + 1; i < length; ++i)
+            {
+                if (moveList.getScore(i) > moveList.getScore(best))
+                {
+                    best = i;
+                }
+            }
+            BOOST_CHECK(moveList.bestIndex(first, length) == best);
+        }
+    }
+
+    MoveList moveList;
+    const Move m1(Square::H4, Square::F5, Piece::Empty);
+    const Move m2(Square::C6, Square::D4, Piece::Empty);
+    moveList.emplace_back(m1);
+    moveList.emplace_back(m2);
+    moveList.setScore(1, 50);
+    moveList.swap(0, 1);
+    BOOST_CHECK(moveList.getMove(0) == m2 && moveList.getScore(0) == 50);
+    BOOST_CHECK(moveList.getMove(1) == m1 && moveList.getScore(1) == 0);
+}
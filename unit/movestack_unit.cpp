@@ -0,0 +1,52 @@
+/*
+    Hakkapeliitta - A UCI chess engine. Copyright (C) 2013-2015 Mikko Aarnos.
+
+    Hakkapeliitta is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Hakkapeliitta is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Hakkapeliitta. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "..\src\movestack.hpp"
+#include <boost\test\unit_test.hpp>
+
+BOOST_AUTO_TEST_CASE(StackMoveListsAreContiguous)
+{
+    MoveStack moveStack;
+    const Move m1(Square::H4, Square::F5, Piece::Empty);
+    const Move m2(Square::C6, Square::D4, Piece::Empty);
+    const Move m3(Square::E8, Square::C8, Piece::King);
+
+    StackMoveList moveList(moveStack);
+    moveList.emplace_back(m1);
+    moveList.emplace_back(m2);
+    moveList.setScore(1, -76);
+
+    {
+        // The second list starts right after the moves of the first one, so it must not touch them.
+        StackMoveList moveList2(moveStack);
+        BOOST_CHECK(moveList2.empty());
+        moveList2.emplace_back(m3);
+        moveList2.setScore(0, 981);
+        BOOST_CHECK(moveList2.getMove(0) == m3);
+        BOOST_CHECK(moveList2.getScore(0) == 981);
+    }
+
+    BOOST_CHECK(moveList.size() == 2);
+    BOOST_CHECK(moveList.getMove(0) == m1);
+    BOOST_CHECK(moveList.getMove(1) == m2);
+    BOOST_CHECK(moveList.getScore(1) == -76);
+
+    // After the second list is gone the first one can grow again.
+    moveList.emplace_back(m3);
+    BOOST_CHECK(moveList.size() == 3);
+    BOOST_CHECK(moveList.getMove(2) == m3);
+}
@@ -0,0 +1,47 @@
+/*
+    Hakkapeliitta - A UCI chess engine. Copyright (C) 2013-2015 Mikko Aarnos.
+
+    Hakkapeliitta is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Hakkapeliitta is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Hakkapeliitta. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "..\src\packed_position.hpp"
+#include <boost\test\unit_test.hpp>
+
+BOOST_AUTO_TEST_CASE(PackAndUnpackPosition)
+{
+    const std::array<std::string, 4> fens = {
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w Kq - 3 17",
+        "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 b - - 42 60"
+    };
+
+    for (auto& fen : fens)
+    {
+        const Position pos(fen);
+        PackedPosition packedPosition(pos, -123);
+        packedPosition.setResult(PackedPosition::Loss);
+        const auto unpacked = packedPosition.getPosition();
+
+        BOOST_CHECK(unpacked.getHashKey() == pos.getHashKey());
+        BOOST_CHECK(unpacked.getOccupiedSquares() == pos.getOccupiedSquares());
+        BOOST_CHECK(unpacked.getSideToMove() == pos.getSideToMove());
+        BOOST_CHECK(unpacked.getCastlingRights() == pos.getCastlingRights());
+        BOOST_CHECK(unpacked.getEnPassantSquare() == pos.getEnPassantSquare());
+        BOOST_CHECK(unpacked.getFiftyMoveDistance() == pos.getFiftyMoveDistance());
+        BOOST_CHECK(unpacked.getGamePly() == pos.getGamePly());
+        BOOST_CHECK(packedPosition.getScore() == -123);
+        BOOST_CHECK(packedPosition.getResult() == PackedPosition::Loss);
+    }
+}
@@ -21,17 +21,47 @@
 BOOST_AUTO_TEST_CASE(AllCasesPHT)
 {
     PawnHashTable pht;
-    int scoreOp, scoreEd;
+    PawnHashTable::PawnHashTableEntry entry;
 
-    pht.save(5270488176186631498, 15, 20);
+    entry.setScores(15, 20);
+    entry.setSemiOpenFiles(Color::White, 0x81);
+    entry.setKingShelter(Color::Black, 6, 12);
+    pht.save(5270488176186631498, entry);
 
-    BOOST_CHECK(pht.probe(5270488176186631498, scoreOp, scoreEd));
-    BOOST_CHECK(scoreOp == 15);
-    BOOST_CHECK(scoreEd == 20);
+    auto hashEntry = pht.probe(5270488176186631498);
+    BOOST_CHECK(hashEntry != nullptr);
+    BOOST_CHECK(hashEntry->getScoreOp() == 15);
+    BOOST_CHECK(hashEntry->getScoreEd() == 20);
+    BOOST_CHECK(hashEntry->isSemiOpenFile(Color::White, 0));
+    BOOST_CHECK(!hashEntry->isSemiOpenFile(Color::White, 1));
+    BOOST_CHECK(hashEntry->getKingShelter(Color::Black, 6) == 12);
+    // The first entry of a bucket must be at the start of a cacheline.
+    BOOST_CHECK(reinterpret_cast<uintptr_t>(hashEntry) % 64 == 0);
 
     pht.clear();
-    BOOST_CHECK(!pht.probe(5270488176186631498, scoreOp, scoreEd));
+    BOOST_CHECK(!pht.probe(5270488176186631498));
+    // An empty table must not produce a hit for a position without any pawns.
+    BOOST_CHECK(!pht.probe(0));
 }
 
+BOOST_AUTO_TEST_CASE(ReplacementPHT)
+{
+    PawnHashTable pht;
+    PawnHashTable::PawnHashTableEntry entry;
+    // All of these map to the same bucket.
+    const HashKey first = 1ULL << 63, second = 2ULL << 60, third = 3ULL << 60;
 
+    entry.setScores(1, 1);
+    pht.save(first, entry);
+    entry.setScores(2, 2);
+    pht.save(second, entry);
 
+    // Both entries fit into the bucket. Probing the first one makes the second one the least recently used.
+    BOOST_CHECK(pht.probe(second) && pht.probe(first));
+    entry.setScores(3, 3);
+    pht.save(third, entry);
+
+    BOOST_CHECK(pht.probe(first) && pht.probe(first)->getScoreOp() == 1);
+    BOOST_CHECK(pht.probe(third) && pht.probe(third)->getScoreOp() == 3);
+    BOOST_CHECK(!pht.probe(second));
+}
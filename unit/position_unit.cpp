@@ -17,6 +17,7 @@
 
 #include "..\src\position.hpp"
 #include <boost\test\unit_test.hpp>
+#include "..\src\movegen.hpp"
 
 BOOST_AUTO_TEST_CASE(GENERAL_FUNCTIONS_1)
 {
@@ -104,5 +105,92 @@ BOOST_AUTO_TEST_CASE(SEE_AND_MVVLVA)
     }
 }
 
+BOOST_AUTO_TEST_CASE(SEE_THRESHOLD)
+{
+    // Promotions with and without recaptures, en passant, castling and a king which cannot recapture.
+    const std::array<std::string, 5> fens = {{
+        "r1bqk2r/2p1bppp/p1np1n2/1p2p3/4P3/1BP2N2/PP1P1PPP/RNBQR1K1 b kq - 0 8",
+        "2r3k1/1q1nbppp/r3p3/3pP3/pPpP4/P1Q2N2/2RN1PPP/2R4K b - b3 0 23",
+        "8/4k3/8/8/RrR1N2r/8/5K2/8 b - - 11 1",
+        "1r2r1k1/P1P2ppp/8/8/8/8/5PPP/1R1R2K1 w - - 0 1",
+        "8/8/8/3k4/3p4/4Q3/8/3RK3 w - - 0 1"
+    }};
+
+    for (auto& fen : fens)
+    {
+        const Position pos(fen);
+        const auto inCheck = pos.inCheck();
+        MoveList moveList;
+        inCheck ? MoveGen::generateLegalEvasions(pos, moveList) : MoveGen::generatePseudoLegalMoves(pos, moveList);
+        for (auto i = 0; i < moveList.size(); ++i)
+        {
+            const auto move = moveList.getMove(i);
+            const auto seeScore = pos.SEE(move);
+            for (auto threshold : { seeScore - 1, static_cast<int>(seeScore), seeScore + 1, -1000, -100, 0, 100, 1000 })
+            {
+                BOOST_CHECK(pos.seeGe(move, threshold) == (seeScore >= threshold));
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(HASH_KEYS_AFTER_MOVE)
+{
+    // Castling, en passant, promotions with and without captures and a rook capture losing castling rights.
+    const std::array<std::string, 4> fens = {{
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "r3k2r/8/8/8/3pPp2/8/8/R3K2R b KQkq e3 0 1",
+        "n1n5/PPPk4/8/8/8/8/4Kppp/5N1N b - - 0 1",
+        "r3k2r/1P6/8/8/8/8/6p1/R3K2R w KQkq - 0 1"
+    }};
 
+    for (auto& fen : fens)
+    {
+        const Position pos(fen);
+        MoveList moveList;
+        MoveGen::generatePseudoLegalMoves(pos, moveList);
+        for (auto i = 0; i < moveList.size(); ++i)
+        {
+            const auto move = moveList.getMove(i);
+            if (!pos.legal(move, false))
+            {
+                continue;
+            }
+            Position newPosition(pos);
+            newPosition.makeMove(move);
+            BOOST_CHECK(pos.hashKeyAfter(move) == newPosition.getHashKey());
+            BOOST_CHECK(pos.pawnHashKeyAfter(move) == newPosition.getPawnHashKey());
+        }
+    }
+}
 
+BOOST_AUTO_TEST_CASE(LEGAL_MOVE_GENERATION)
+{
+    // Pinned pieces of all kinds, a pinned pawn capturing its pinner, an en passant capture leaving the king in check along the rank and castling through attacked squares.
+    const std::array<std::string, 5> fens = {{
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        "8/8/8/KPp4r/8/8/8/7k w - c6 0 1",
+        "4k3/8/2b5/1q6/2PN4/1B1RN1r1/3K4/8 w - - 0 1",
+        "r3k2r/8/8/8/2b5/8/8/R3K2R w KQkq - 0 1"
+    }};
+
+    for (auto& fen : fens)
+    {
+        const Position pos(fen);
+        MoveList pseudoLegal, legal;
+        MoveGen::generatePseudoLegalMoves(pos, pseudoLegal);
+        MoveGen::generateLegalMoves(pos, legal);
+
+        auto marker = 0;
+        for (auto i = 0; i < pseudoLegal.size(); ++i)
+        {
+            if (pos.legal(pseudoLegal.getMove(i), false))
+            {
+                BOOST_REQUIRE(marker < legal.size());
+                BOOST_CHECK(pseudoLegal.getMove(i) == legal.getMove(marker++));
+            }
+        }
+        BOOST_CHECK(marker == legal.size());
+    }
+}
@@ -0,0 +1,87 @@
+/*
+    Hakkapeliitta - A UCI chess engine. Copyright (C) 2013-2015 Mikko Aarnos.
+
+    Hakkapeliitta is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Hakkapeliitta is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Hakkapeliitta. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "..\src\utils\threadpool.hpp"
+#include <boost\test\unit_test.hpp>
+#include <memory>
+#include <stdexcept>
+
+BOOST_AUTO_TEST_CASE(THREADPOOL_SUBMIT)
+{
+    ThreadPool tp(2);
+    auto sum = tp.submit([](int a, int b) { return a + b; }, 2, 3);
+    BOOST_CHECK(sum.get() == 5);
+
+    // Move-only arguments are moved into the job.
+    std::unique_ptr<int> value(new int(7));
+    auto moved = tp.submit([](std::unique_ptr<int>& p) { return *p; }, std::move(value));
+    BOOST_CHECK(moved.get() == 7);
+
+    auto failed = tp.submit([]() -> int { throw std::runtime_error("failed"); });
+    BOOST_CHECK_THROW(failed.get(), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(THREADPOOL_PARALLEL_FOR)
+{
+    ThreadPool tp(3);
+    std::vector<std::atomic<int>> counts(10000);
+    for (auto& count : counts)
+    {
+        count = 0;
+    }
+    tp.parallelFor(0, counts.size(), [&](size_t i) { ++counts[i]; });
+    BOOST_CHECK(std::all_of(counts.begin(), counts.end(), [](const std::atomic<int>& count) { return count == 1; }));
+
+    // Nested fork/join, more than there are threads.
+    std::atomic<int> total(0);
+    tp.parallelFor(0, 16, [&](size_t) { tp.parallelFor(0, 100, [&](size_t) { ++total; }, 10); });
+    BOOST_CHECK(total == 1600);
+
+    // Without threads the waiting thread does everything itself.
+    ThreadPool empty(0);
+    total = 0;
+    empty.parallelFor(0, 100, [&](size_t) { ++total; });
+    BOOST_CHECK(total == 100);
+}
+
+BOOST_AUTO_TEST_CASE(THREADPOOL_TASK_GROUP)
+{
+    ThreadPool tp(2);
+    ThreadPool::TaskGroup group(tp);
+    std::atomic<int> total(0);
+    for (auto i = 0; i < 100; ++i)
+    {
+        group.run([&]() { ++total; });
+    }
+    group.run([]() { throw std::runtime_error("failed"); });
+    BOOST_CHECK_THROW(group.wait(), std::runtime_error);
+    BOOST_CHECK(total == 100);
+}
+
+BOOST_AUTO_TEST_CASE(THREADPOOL_SHUTDOWN)
+{
+    // Every job added is run before the destructor returns.
+    std::atomic<int> total(0);
+    {
+        ThreadPool tp(2);
+        for (auto i = 0; i < 1000; ++i)
+        {
+            tp.addJob([&](int amount) { total += amount; }, 1);
+        }
+    }
+    BOOST_CHECK(total == 1000);
+}
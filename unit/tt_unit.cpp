@@ -16,14 +16,16 @@
 */
 
 #include "..\src\tt.hpp"
+#include <sstream>
 #include <boost\test\unit_test.hpp>
 
 BOOST_AUTO_TEST_CASE(AllCasesTT)
 {
     TranspositionTable tt;
     Move m(Square::H4, Square::F5, Piece::Empty);
+    BOOST_CHECK(tt.hashFull() == 0);
 
-    tt.save(5770153743293125963, m, -23, 7, TranspositionTable::Flags::ExactScore);
+    tt.save(5770153743293125963, m, -23, 7, TranspositionTable::Flags::ExactScore, 12);
 
     auto ttEntry = tt.probe(5770153743293125963);
     BOOST_CHECK(ttEntry);
@@ -31,11 +33,76 @@ BOOST_AUTO_TEST_CASE(AllCasesTT)
     BOOST_CHECK(ttEntry->getScore() == -23);
     BOOST_CHECK(ttEntry->getDepth() == 7);
     BOOST_CHECK(ttEntry->getFlags() == TranspositionTable::Flags::ExactScore);
+    BOOST_CHECK(ttEntry->getStaticEval() == 12);
+    // The entry went to the start of an empty bucket, which must be at the start of a cacheline.
+    BOOST_CHECK(reinterpret_cast<uintptr_t>(ttEntry) % 64 == 0);
+    // Only the upper bits of the hash key are stored so a key differing in them must not match.
+    BOOST_CHECK(!tt.probe(5770153743293125963 ^ (1ULL << 63)));
 
     tt.clear();
     ttEntry = tt.probe(5770153743293125963);
     BOOST_CHECK(!ttEntry);
+    // Empty entries must not match hash keys with the upper bits set to zero.
+    BOOST_CHECK(!tt.probe(0));
+
+    // Fill the first bucket, which is one of the sampled ones.
+    for (auto i = 0; i < 6; ++i)
+    {
+        tt.save(static_cast<HashKey>(i + 1) << 48, m, 0, 1, TranspositionTable::Flags::ExactScore, 0);
+    }
+    BOOST_CHECK(tt.hashFull() == 5);
 }
 
 
 
+
+BOOST_AUTO_TEST_CASE(SaveAndLoadTT)
+{
+    TranspositionTable tt;
+    Move m(Square::H4, Square::F5, Piece::Empty);
+    tt.setSize(1);
+    tt.save(5770153743293125963, m, -23, 7, TranspositionTable::Flags::LowerBoundScore, 12);
+
+    std::stringstream ss;
+    BOOST_CHECK(tt.save(ss));
+
+    TranspositionTable loaded;
+    BOOST_CHECK(loaded.load(ss));
+    BOOST_CHECK(loaded.getSize() == 1);
+    const auto ttEntry = loaded.probe(5770153743293125963);
+    BOOST_CHECK(ttEntry);
+    BOOST_CHECK(ttEntry->getBestMove() == m);
+    BOOST_CHECK(ttEntry->getScore() == -23);
+    BOOST_CHECK(ttEntry->getFlags() == TranspositionTable::Flags::LowerBoundScore);
+
+    // Something else than a saved table must be rejected without losing the table.
+    std::stringstream garbage(std::string(1000, 'x'));
+    BOOST_CHECK(!loaded.load(garbage));
+    BOOST_CHECK(loaded.probe(5770153743293125963));
+
+    // A truncated table must not be accepted.
+    std::stringstream truncated(ss.str().substr(0, 1000));
+    BOOST_CHECK(!loaded.load(truncated));
+    BOOST_CHECK(!loaded.probe(5770153743293125963));
+}
+
+BOOST_AUTO_TEST_CASE(SharedGenerationTT)
+{
+    TranspositionTable first, second;
+    Move m(Square::H4, Square::F5, Piece::Empty);
+    BOOST_REQUIRE(first.attach("hakkapeliitta_tt_unit", 1));
+    BOOST_REQUIRE(second.attach("hakkapeliitta_tt_unit", 1));
+
+    // A search started by one process must not make the entries of the other look stale.
+    second.startNewSearch();
+    for (auto i = 0; i < 6; ++i)
+    {
+        second.save(static_cast<HashKey>(i + 1) << 48, m, 0, 1, TranspositionTable::Flags::ExactScore, 0);
+    }
+    BOOST_CHECK(first.hashFull() == 5);
+    BOOST_CHECK(second.hashFull() == 5);
+
+    first.startNewSearch();
+    BOOST_CHECK(first.hashFull() == 0);
+    BOOST_CHECK(second.hashFull() == 0);
+}
@@ -20,6 +20,7 @@
 #include <boost\math\special_functions\gamma.hpp>
 #include <boost\test\unit_test.hpp>
 #include "..\src\bitboards.hpp"
+#include "..\src\position.hpp"
 
 struct ZobristFixture 
 {
@@ -130,3 +131,35 @@ BOOST_FIXTURE_TEST_CASE(RUNS_TEST, ZobristFixture)
 
     BOOST_CHECK(pValue >= 0.01);
 }
+
+BOOST_AUTO_TEST_CASE(REVERSIBLE_MOVES_TEST)
+{
+    Position pos("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+
+    // A knight move can be taken back, so it must be found.
+    auto newPosition = pos;
+    newPosition.makeMove(Move(Square::G1, Square::F3, Piece::Empty));
+    const auto move = Zobrist::reversibleMove(pos.getHashKey() ^ newPosition.getHashKey());
+    BOOST_CHECK(!move.empty());
+    BOOST_CHECK((move.getFrom() == Square::G1 && move.getTo() == Square::F3) || (move.getFrom() == Square::F3 && move.getTo() == Square::G1));
+
+    // A pawn move can't.
+    newPosition = pos;
+    newPosition.makeMove(Move(Square::E2, Square::E4, Piece::Empty));
+    BOOST_CHECK(Zobrist::reversibleMove(pos.getHashKey() ^ newPosition.getHashKey()).empty());
+
+    // Every reversible move of every piece is in the table.
+    auto count = 0;
+    for (Piece p = Piece::WhiteKnight; p <= Piece::BlackKing; ++p)
+    {
+        for (Square from = Square::A1; from <= Square::H8; ++from)
+        {
+            for (Square to = from + 1; to <= Square::H8; ++to)
+            {
+                const auto key = Zobrist::pieceHashKey(p, from) ^ Zobrist::pieceHashKey(p, to) ^ Zobrist::turnHashKey();
+                count += !Zobrist::reversibleMove(key).empty();
+            }
+        }
+    }
+    BOOST_CHECK(count == 3668);
+}